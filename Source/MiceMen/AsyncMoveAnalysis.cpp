@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AsyncMoveAnalysis.h"
+#include "TranspositionTable.h"
+#include "Async/Async.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/PlatformTime.h"
+
+FAsyncMoveAnalysis::FTask::FTask()
+	: bAllMoves(true)
+	, StartTime(0.0)
+	, bCancelled(false)
+	, bComplete(false)
+	, bHasResult(false)
+{
+}
+
+FAsyncMoveAnalysis::~FAsyncMoveAnalysis()
+{
+	Cancel();
+}
+
+void FAsyncMoveAnalysis::Start(const FMatchState& Root, const TSharedPtr<FTranspositionTable, ESPMode::ThreadSafe>& Table, bool bAllMoves)
+{
+	Cancel();
+
+	Task = MakeShared<FTask, ESPMode::ThreadSafe>();
+	Task->Root = Root;
+	Task->Table = Table;
+	Task->bAllMoves = bAllMoves;
+	Task->StartTime = FPlatformTime::Seconds();
+
+	TSharedPtr<FTask, ESPMode::ThreadSafe> RunningTask = Task;
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [RunningTask]()
+	{
+		Run(*RunningTask);
+	});
+}
+
+void FAsyncMoveAnalysis::Cancel()
+{
+	if (Task.IsValid())
+	{
+		Task->bCancelled = true;
+		Task.Reset();
+	}
+}
+
+bool FAsyncMoveAnalysis::IsComplete() const
+{
+	return Task.IsValid() && Task->bComplete.Load();
+}
+
+double FAsyncMoveAnalysis::GetElapsedSeconds() const
+{
+	return Task.IsValid() ? FPlatformTime::Seconds() - Task->StartTime : 0.0;
+}
+
+bool FAsyncMoveAnalysis::GetResult(FMoveAnalysisResult& OutResult) const
+{
+	if (!Task.IsValid())
+	{
+		return false;
+	}
+	FScopeLock Lock(&Task->ResultLock);
+	if (Task->bHasResult)
+	{
+		OutResult = Task->Result;
+	}
+	return Task->bHasResult;
+}
+
+void FAsyncMoveAnalysis::Run(FTask& InTask)
+{
+	auto Publish = [&InTask](const FMoveAnalysisResult& Result)
+	{
+		FScopeLock Lock(&InTask.ResultLock);
+		InTask.Result = Result;
+		InTask.bHasResult = true;
+	};
+
+	// No deadline, the analysis runs until it is cancelled or has nothing left to find
+	if (InTask.bAllMoves)
+	{
+		FMoveAnalysisSettings Settings;
+		Settings.LatencySeconds = TNumericLimits<double>::Max();
+		Settings.Table = InTask.Table.Get();
+		Settings.CancelFlag = &InTask.bCancelled;
+		Settings.OnIteration = Publish;
+		FMoveAnalysis::Analyze(InTask.Root, Settings);
+	}
+	else
+	{
+		FBoardSearch Search(InTask.Table.Get());
+		Search.SetCancelFlag(&InTask.bCancelled);
+		Search.SetIterationCallback([&Publish](const FBoardSearchResult& SearchResult)
+		{
+			FMoveAnalysisResult Result;
+			FMoveEvaluation& Evaluation = Result.Moves[Result.Moves.AddDefaulted()];
+			Evaluation.Move = SearchResult.BestMove;
+			Evaluation.Score = SearchResult.Score;
+			Evaluation.Nodes = SearchResult.Nodes;
+			Result.Depth = SearchResult.Depth;
+			Result.Nodes = SearchResult.Nodes;
+			Result.Seconds = SearchResult.Seconds;
+			Publish(Result);
+		});
+		Search.Search(InTask.Root, TNumericLimits<double>::Max());
+	}
+	InTask.bComplete = true;
+}
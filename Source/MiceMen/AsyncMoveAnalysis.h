@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MoveAnalysis.h"
+#include "Templates/Atomic.h"
+#include "HAL/CriticalSection.h"
+
+/**
+ * Runs the analysis of one position on a background thread so the game thread never waits for it.
+ * The analysis works on its own copy of the position and deepens until it is cancelled, reaches the
+ * depth limit or every outcome is forced; meanwhile the ranking of the last completed iteration can
+ * be read at any time. Cancelling does not wait either: the background thread notices within a few
+ * thousand nodes and drops its work, the state it shares with this object is freed by whoever lets go last.
+ */
+class MICEMEN_API FAsyncMoveAnalysis
+{
+public:
+	~FAsyncMoveAnalysis();
+
+	// Start analysing Root, cancelling the analysis still running. Without bAllMoves a single search
+	// looks for the best move only and the ranking holds just that move
+	void Start(const FMatchState& Root, const TSharedPtr<FTranspositionTable, ESPMode::ThreadSafe>& Table, bool bAllMoves = true);
+
+	void Cancel();
+
+	// An analysis was started and not cancelled, it may have ended by itself already
+	bool IsActive() const { return Task.IsValid(); }
+
+	// The analysis ended by itself, its ranking will not change anymore
+	bool IsComplete() const;
+
+	// Position being analysed, only valid while active
+	const FMatchState& GetRoot() const { return Task->Root; }
+
+	double GetElapsedSeconds() const;
+
+	// Copy the ranking of the last completed iteration, false until the first one completed
+	bool GetResult(FMoveAnalysisResult& OutResult) const;
+
+private:
+	struct FTask
+	{
+		FTask();
+
+		FMatchState Root;
+		TSharedPtr<FTranspositionTable, ESPMode::ThreadSafe> Table;
+		bool bAllMoves;
+		double StartTime;
+
+		TAtomic<bool> bCancelled;
+		TAtomic<bool> bComplete;
+
+		// Written by the background thread after every iteration, read by the game thread
+		mutable FCriticalSection ResultLock;
+		FMoveAnalysisResult Result;
+		bool bHasResult;
+	};
+
+	static void Run(FTask& InTask);
+
+	// Also held by the background thread until it returns
+	TSharedPtr<FTask, ESPMode::ThreadSafe> Task;
+};
@@ -10,8 +10,8 @@
 // Sets default values
 ABlock::ABlock()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// Blocks never tick, their movement is animated by the grid
+	PrimaryActorTick.bCanEverTick = false;
 
 	//Structure to hold one-time initialization
 	struct FConstructorStatics
@@ -43,6 +43,10 @@ ABlock::ABlock()
 	VisualMesh->SetRelativeLocation(FVector(0.0f, 0.0f, 0.0f));
 	VisualMesh->SetupAttachment(RootComponent);
 
+	// Goals are scored by AGrid, pieces must not set off the overlap boxes of the ScoreBoard actors as well
+	VisualMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	VisualMesh->SetGenerateOverlapEvents(false);
+
 	// Save pointers to the materials
 	BaseMaterial = ConstructorStatics.BaseMaterial.Get();
 	BlueMaterial = ConstructorStatics.BlueMaterial.Get();
@@ -56,27 +60,6 @@ void ABlock::BeginPlay()
 	Super::BeginPlay();
 }
 
-// Called every frame
-void ABlock::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-
-	if (bMoving && LengthMoved < 1.0f) // If actor is moving but hasn't reached its destination
-	{
-		LengthMoved += MovementIteration * DeltaTime;
-		SetActorLocation(FMath::Lerp(MovementStartLocation, MovementTargetLocation, LengthMoved));
-	}
-	else if (bMoving && LengthMoved >= 1.0f) // If actor is moving but destination has been reached
-	{
-		SetActorLocation(FMath::Lerp(MovementStartLocation, MovementTargetLocation, 1.0f));
-		bMoving = false;
-		if (GetActorLocation().Y != 0.0f)
-		{
-			MoveTo(FVector(GetActorLocation().X, 0.0f, GetActorLocation().Z), 1);
-		}
-	}
-}
-
 // Set the mesh of our block
 void ABlock::SetMesh(UStaticMesh* mesh)
 {
@@ -105,6 +88,7 @@ void ABlock::SetCoordinates(FIntPoint point)
 void ABlock::SetType(EType type)
 {
 	ActorType = type;
+	bPainted = false;
 	switch (type)
 	{
 	case EType::Block:
@@ -119,53 +103,6 @@ void ABlock::SetType(EType type)
 	}
 }
 
-// Start movement towards a given coordinate, distance input is used to determine how fast the block should move
-void ABlock::MoveTo(FVector TargetLocation, int32 MovementDistanceInBlocks)
-{
-	if (!bMoving) //Only execute the code below if the actor is not already moving
-	{
-		MovementStartLocation = GetActorLocation();
-		MovementTargetLocation = TargetLocation;
-
-		//Divide movespeed by number of blocks to move through for speed consistency when using linear interpolation
-		MovementIteration = MoveSpeed / MovementDistanceInBlocks;
-
-		LengthMoved = 0.0f;
-		bMoving = true;
-	}
-}
-
-// Update neighbour variables
-void ABlock::UpdateNeighbours()
-{
-	FIntPoint AheadCoordinates;
-	FIntPoint BelowCoordinates = FIntPoint(Coordinates.X, Coordinates.Y - 1);
-	if (ActorType == EType::Blue)
-	{
-		AheadCoordinates = FIntPoint(Coordinates.X - 1, Coordinates.Y);
-	}
-	else
-	{
-		AheadCoordinates = FIntPoint(Coordinates.X + 1, Coordinates.Y);
-	}
-	if (GameBoard->BlockMap.Contains(BelowCoordinates))
-	{
-		Below = GameBoard->BlockMap[BelowCoordinates];
-	}
-	else
-	{
-		Below = nullptr;
-	}
-	if (GameBoard->BlockMap.Contains(AheadCoordinates))
-	{
-		Ahead = GameBoard->BlockMap[AheadCoordinates];
-	}
-	else
-	{
-		Ahead = nullptr;
-	}
-}
-
 // Toggle highlighting this block with a different material than usual
 void ABlock::HighlightToggle()
 {
@@ -184,18 +121,6 @@ void ABlock::HighlightToggle()
 	}
 }
 
-// Returns true if there are no blocks below this one, unless this block is at the bottom of the grid. If the block is currently moving it will return false regardless. 
-bool ABlock::IsFalling()
-{
-	return (Below == nullptr && Coordinates.Y != 0 && !bMoving);
-}
-
-// Returns true if there are no block ahead and this block is not currently moving.
-bool ABlock::CanWalk()
-{
-	return (Ahead == nullptr && !bMoving);
-}
-
 int32 ABlock::GetTypeInInt()
 {
 	return int32(ActorType);
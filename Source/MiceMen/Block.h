@@ -3,12 +3,13 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Grid.h"
 #include "Materials/Material.h"
 #include "UObject/ObjectMacros.h"
 #include "GameFramework/Actor.h"
 #include "Block.generated.h"
 
+class AGrid;
+
 UENUM()
 enum class EType
 {
@@ -38,9 +39,6 @@ protected:
 	virtual void BeginPlay() override;
 
 public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Board Info")
 	FIntPoint Coordinates;
 
@@ -59,9 +57,6 @@ public:
 	UPROPERTY(VisibleAnywhere)
 	UStaticMeshComponent* VisualMesh;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
-	float MoveSpeed = 5.0f;
-
 	void SetCoordinates(FIntPoint point);
 
 	void SetType(EType type);
@@ -71,35 +66,17 @@ public:
 	void SetMaterial(UMaterialInstance* material);
 	void SetMaterial(UMaterial* material);
 
-	void MoveTo(FVector TargetLocation, int32 MovementDistanceInBlocks);
-
-	void UpdateNeighbours();
-
 	void HighlightToggle();
 
-	UPROPERTY(VisibleAnywhere)
-	AActor* Below;
-
-	UPROPERTY(VisibleAnywhere)
-	AActor* Ahead;
-
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
 	AGrid* GameBoard;
 
 	EType ActorType;
 
-	bool IsFalling();
-	bool CanWalk();
-
 	UFUNCTION(BlueprintCallable)
 	int32 GetTypeInInt();
 
 private:
 
 	bool bPainted = false;
-	bool bMoving = false;
-	FVector MovementTargetLocation;
-	FVector MovementStartLocation;
-	float LengthMoved = 0.0f;
-	float MovementIteration;
 };
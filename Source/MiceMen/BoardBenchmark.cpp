@@ -0,0 +1,293 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BoardBenchmark.h"
+#include "BoardGenerator.h"
+#include "HAL/PlatformTime.h"
+
+static const int32 NumPositions = 256;
+static const int32 MovesBeforePosition = 20;
+
+// Row of the cheese shelf splitting the worst case board, red runs above it and blue below
+static const int32 ShelfRow = FBoardState::Height / 2;
+
+FBoardBenchmark::FBoardBenchmark(int32 InSeed, double InSecondsPerCase, FAllocationCounter InCountAllocations, FIntPoint LargeBoardSize, int32 LargeBoardMicePerTeam)
+	: Seed(InSeed)
+	, SecondsPerCase(InSecondsPerCase)
+	, CountAllocations(InCountAllocations)
+	, LargeStart(LargeBoardSize.X, LargeBoardSize.Y, LargeBoardMicePerTeam)
+	, LargeBoard(LargeStart)
+{
+	const FRandomStream Random(Seed);
+	Positions.Reserve(NumPositions);
+	PositionMoves.Reserve(NumPositions);
+	while (Positions.Num() < NumPositions)
+	{
+		FMatchState State;
+		State.Generate(FRandomStream(Random.GetUnsignedInt()));
+
+		FBoardMove Moves[FMatchState::MaxMoves];
+		for (int32 i = 0; i < MovesBeforePosition && !State.IsFinished(); ++i)
+		{
+			State.ApplyMove(Moves[Random.RandRange(0, State.GetLegalMoves(Moves) - 1)]);
+		}
+		if (!State.IsFinished())
+		{
+			PositionMoves.Add(Moves[Random.RandRange(0, State.GetLegalMoves(Moves) - 1)]);
+			Positions.Add(State);
+		}
+	}
+
+	// Red mice on top of the shelf fall onto it and walk right, blue mice under it fall to the floor and walk left
+	for (int32 x = 0; x < FBoardState::Width; ++x)
+	{
+		CascadeBoard.SetCell(x, 0, EBoardCell::Cheese);
+		CascadeBoard.SetCell(x, ShelfRow, EBoardCell::Cheese);
+	}
+	for (int32 i = 0; i < FBoardState::MicePerTeam; ++i)
+	{
+		const int32 Column = i % (FBoardState::Width / 2);
+		const int32 Row = i / (FBoardState::Width / 2);
+		CascadeBoard.SetCell(Column, FBoardState::Height - 1 - Row, EBoardCell::Red);
+		CascadeBoard.SetCell(FBoardState::Width - 1 - Column, ShelfRow - 1 - Row, EBoardCell::Blue);
+	}
+
+	// Blue in the first column and red in the last, each mouse walks out as soon as the one below it left
+	for (int32 y = 0; y < FBoardState::MicePerTeam; ++y)
+	{
+		GoalBoard.SetCell(0, y, EBoardCell::Blue);
+		GoalBoard.SetCell(FBoardState::Width - 1, y, EBoardCell::Red);
+	}
+
+	Steps.Reserve(FBoardState::Width * FBoardState::Height * 4);
+
+	LargeStart.GenerateCheese(Random);
+	LargeStart.GenerateMice(Random);
+	LargeStart.Settle();
+}
+
+void FBoardBenchmark::Run(TArray<FBoardBenchmarkResult>& OutResults)
+{
+	OutResults.Add(Measure(TEXT("GenerateMatch"), &FBoardBenchmark::GenerateMatch));
+	OutResults.Add(Measure(TEXT("GenerateFairMatch"), &FBoardBenchmark::GenerateFairMatch));
+	OutResults.Add(Measure(TEXT("MoveColumn"), &FBoardBenchmark::MoveColumn));
+	OutResults.Add(Measure(TEXT("ApplyMove"), &FBoardBenchmark::ApplyMove));
+	OutResults.Add(Measure(TEXT("ApplyUndoMove"), &FBoardBenchmark::ApplyUndoMove));
+	OutResults.Add(Measure(TEXT("SettleRecorded"), &FBoardBenchmark::SettleRecorded));
+	OutResults.Add(Measure(TEXT("SettleWorstCase"), &FBoardBenchmark::SettleWorstCase));
+	OutResults.Add(Measure(TEXT("SettleGoalExits"), &FBoardBenchmark::SettleGoalExits));
+	OutResults.Add(Measure(TEXT("TeamColumns"), &FBoardBenchmark::TeamColumns));
+	OutResults.Add(Measure(TEXT("LegalColumns"), &FBoardBenchmark::LegalColumns));
+	OutResults.Add(Measure(TEXT("LargeGenerate"), &FBoardBenchmark::LargeGenerate));
+	OutResults.Add(Measure(TEXT("LargeMoveColumn"), &FBoardBenchmark::LargeMoveColumn));
+	OutResults.Add(Measure(TEXT("LargeTeamColumns"), &FBoardBenchmark::LargeTeamColumns));
+}
+
+FBoardBenchmarkResult FBoardBenchmark::Measure(const TCHAR* Name, FCase Case)
+{
+	// Double the batch until it takes a measurable time, then size the real run from it
+	int64 NumOperations = 1;
+	double Seconds = 0.0;
+	volatile uint64 Sink = 0;
+	for (;;)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		Sink = Sink + (this->*Case)(NumOperations);
+		Seconds = FPlatformTime::Seconds() - StartTime;
+		if (Seconds >= SecondsPerCase * 0.1)
+		{
+			break;
+		}
+		NumOperations *= 2;
+	}
+	NumOperations = FMath::Max<int64>(int64(NumOperations * SecondsPerCase / Seconds), 1);
+
+	const int64 StartAllocations = CountAllocations != nullptr ? CountAllocations() : 0;
+	const double StartTime = FPlatformTime::Seconds();
+	Sink = Sink + (this->*Case)(NumOperations);
+	Seconds = FPlatformTime::Seconds() - StartTime;
+	const int64 Allocations = CountAllocations != nullptr ? CountAllocations() - StartAllocations : 0;
+
+	FBoardBenchmarkResult Result;
+	Result.Name = Name;
+	Result.Operations = NumOperations;
+	Result.NanosecondsPerOperation = Seconds * 1e9 / NumOperations;
+	Result.AllocationsPerOperation = double(Allocations) / NumOperations;
+	return Result;
+}
+
+// Board generation and the first settle, as done by AGrid::GridInitialization and Populate
+uint64 FBoardBenchmark::GenerateMatch(int64 NumOperations)
+{
+	uint64 Result = 0;
+	FMatchState State;
+	for (int64 i = 0; i < NumOperations; ++i)
+	{
+		State.Generate(FRandomStream(Seed + int32(i)));
+		Result ^= State.GetHash();
+	}
+	return Result;
+}
+
+// A board accepted by FBoardGenerator, including every candidate it rejected on the way
+uint64 FBoardBenchmark::GenerateFairMatch(int64 NumOperations)
+{
+	uint64 Result = 0;
+	const FBoardGenerator Generator;
+	FMatchState State;
+	for (int64 i = 0; i < NumOperations; ++i)
+	{
+		Generator.Generate(Seed + int32(i), State);
+		Result ^= State.GetHash();
+	}
+	return Result;
+}
+
+// Rotating a column alone, without settling
+uint64 FBoardBenchmark::MoveColumn(int64 NumOperations)
+{
+	FBoardState Board = Positions[0].Board;
+	for (int64 i = 0; i < NumOperations; ++i)
+	{
+		Board.MoveColumn(int32(i % FBoardState::Width), (i & 1) != 0);
+	}
+	return Board.Hash;
+}
+
+// A whole turn: history, column rotation and the incremental settle, including the copy of the position
+uint64 FBoardBenchmark::ApplyMove(int64 NumOperations)
+{
+	uint64 Result = 0;
+	for (int64 i = 0; i < NumOperations; ++i)
+	{
+		const int32 Index = int32(i % Positions.Num());
+		FMatchState State = Positions[Index];
+		State.ApplyMove(PositionMoves[Index]);
+		Result ^= State.GetHash();
+	}
+	return Result;
+}
+
+// Trying a move and taking it back in place through its delta, without copying the position
+uint64 FBoardBenchmark::ApplyUndoMove(int64 NumOperations)
+{
+	uint64 Result = 0;
+	FMoveDelta Delta;
+	for (int64 i = 0; i < NumOperations; ++i)
+	{
+		const int32 Index = int32(i % Positions.Num());
+		FMatchState& State = Positions[Index];
+		Steps.Reset();
+		State.ApplyMove(PositionMoves[Index], Delta, Steps);
+		Result ^= State.GetHash();
+		State.UndoMove(Delta, Steps);
+	}
+	return Result;
+}
+
+// What AGrid::MoveColumn hands to SettleBoard: the rotation and every settle step in order
+uint64 FBoardBenchmark::SettleRecorded(int64 NumOperations)
+{
+	uint64 Result = 0;
+	for (int64 i = 0; i < NumOperations; ++i)
+	{
+		const int32 Index = int32(i % Positions.Num());
+		const int32 Column = PositionMoves[Index].Column;
+		FBoardState Board = Positions[Index].Board;
+		Steps.Reset();
+		Board.MoveColumn(Column, PositionMoves[Index].bUpward);
+		Result += Board.Settle(Steps, FBoardState::GetNeighbourColumns(Column));
+	}
+	return Result;
+}
+
+uint64 FBoardBenchmark::SettleWorstCase(int64 NumOperations)
+{
+	uint64 Result = 0;
+	for (int64 i = 0; i < NumOperations; ++i)
+	{
+		FBoardState Board = CascadeBoard;
+		Steps.Reset();
+		Result += Board.Settle(Steps);
+	}
+	return Result;
+}
+
+// Scoring path of the settle, every step moves a mouse into a goal
+uint64 FBoardBenchmark::SettleGoalExits(int64 NumOperations)
+{
+	uint64 Result = 0;
+	for (int64 i = 0; i < NumOperations; ++i)
+	{
+		FBoardState Board = GoalBoard;
+		Steps.Reset();
+		Result += Board.Settle(Steps);
+	}
+	return Result;
+}
+
+// Same as AGrid::TeamColumns, including the array it returns
+uint64 FBoardBenchmark::TeamColumns(int64 NumOperations)
+{
+	uint64 Result = 0;
+	for (int64 i = 0; i < NumOperations; ++i)
+	{
+		const FMatchState& State = Positions[int32(i % Positions.Num())];
+		TArray<int32> Columns;
+		FBoardState::GetColumnList(State.Board.GetTeamColumns(State.SideToMove), Columns);
+		Result += Columns.Num();
+	}
+	return Result;
+}
+
+// The rule check behind AControllerPawn::RemoveInvalidColumn
+uint64 FBoardBenchmark::LegalColumns(int64 NumOperations)
+{
+	uint64 Result = 0;
+	for (int64 i = 0; i < NumOperations; ++i)
+	{
+		Result += Positions[int32(i % Positions.Num())].GetLegalColumns();
+	}
+	return Result;
+}
+
+// Placing every piece of the large board and settling it
+uint64 FBoardBenchmark::LargeGenerate(int64 NumOperations)
+{
+	uint64 Result = 0;
+	for (int64 i = 0; i < NumOperations; ++i)
+	{
+		const FRandomStream Random(Seed + int32(i));
+		LargeBoard.Reset();
+		LargeBoard.GenerateCheese(Random);
+		LargeBoard.GenerateMice(Random);
+		Result += LargeBoard.Settle();
+	}
+	return Result;
+}
+
+// A turn on the large board: rotating a random column and settling, one move after the other
+uint64 FBoardBenchmark::LargeMoveColumn(int64 NumOperations)
+{
+	uint64 Result = 0;
+	const FRandomStream Random(Seed);
+	LargeBoard = LargeStart;
+	for (int64 i = 0; i < NumOperations; ++i)
+	{
+		LargeBoard.MoveColumn(Random.RandRange(0, LargeBoard.Width - 1), Random.RandRange(0, 1) != 0);
+		Result += LargeBoard.Settle();
+	}
+	return Result;
+}
+
+uint64 FBoardBenchmark::LargeTeamColumns(int64 NumOperations)
+{
+	uint64 Result = 0;
+	for (int64 i = 0; i < NumOperations; ++i)
+	{
+		TArray<int32> Columns;
+		LargeStart.GetTeamColumns((i & 1) != 0 ? EBoardCell::Blue : EBoardCell::Red, Columns);
+		Result += Columns.Num();
+	}
+	return Result;
+}
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MatchState.h"
+#include "LargeBoardState.h"
+
+struct FBoardBenchmarkResult
+{
+	const TCHAR* Name = nullptr;
+	int64 Operations = 0;
+	double NanosecondsPerOperation = 0.0;
+	double AllocationsPerOperation = 0.0;
+};
+
+/**
+ * Measures the board hot paths on positions generated from a fixed seed, so two runs
+ * on the same build compare the same work. Each case is the headless code the level uses:
+ * AGrid::MoveColumn and SettleBoard play back FBoardState::MoveColumn and Settle,
+ * AGrid::TeamColumns reads GetTeamColumns and AControllerPawn::RemoveInvalidColumn
+ * filters with FMatchState::GetLegalColumns. The Large cases run the same work on a
+ * FLargeBoardState of the given size to see how it scales with the board.
+ */
+class MICEMEN_API FBoardBenchmark
+{
+public:
+	// Returns how many allocations were made so far, or null if they aren't counted
+	typedef int64 (*FAllocationCounter)();
+
+	FBoardBenchmark(int32 InSeed, double InSecondsPerCase, FAllocationCounter InCountAllocations = nullptr,
+		FIntPoint LargeBoardSize = FIntPoint(256, 256), int32 LargeBoardMicePerTeam = 4000);
+
+	void Run(TArray<FBoardBenchmarkResult>& OutResults);
+
+private:
+	// Run NumOperations operations, returning a value built from their results so they can't be optimized away
+	typedef uint64 (FBoardBenchmark::*FCase)(int64 NumOperations);
+
+	FBoardBenchmarkResult Measure(const TCHAR* Name, FCase Case);
+
+	uint64 GenerateMatch(int64 NumOperations);
+	uint64 GenerateFairMatch(int64 NumOperations);
+	uint64 MoveColumn(int64 NumOperations);
+	uint64 ApplyMove(int64 NumOperations);
+	uint64 ApplyUndoMove(int64 NumOperations);
+	uint64 SettleRecorded(int64 NumOperations);
+	uint64 SettleWorstCase(int64 NumOperations);
+	uint64 SettleGoalExits(int64 NumOperations);
+	uint64 TeamColumns(int64 NumOperations);
+	uint64 LegalColumns(int64 NumOperations);
+	uint64 LargeGenerate(int64 NumOperations);
+	uint64 LargeMoveColumn(int64 NumOperations);
+	uint64 LargeTeamColumns(int64 NumOperations);
+
+	int32 Seed;
+	double SecondsPerCase;
+	FAllocationCounter CountAllocations;
+
+	// Positions a few random moves into a match, with one legal move each
+	TArray<FMatchState> Positions;
+	TArray<FBoardMove> PositionMoves;
+
+	// Every mouse falls and then walks all the way to its goal
+	FBoardState CascadeBoard;
+
+	// Every mouse is stacked right next to its goal
+	FBoardState GoalBoard;
+
+	TArray<FBoardStep> Steps;
+
+	// Generated and settled large board, and the one the Large cases play on
+	FLargeBoardState LargeStart;
+	FLargeBoardState LargeBoard;
+};
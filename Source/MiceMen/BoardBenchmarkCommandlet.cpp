@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BoardBenchmarkCommandlet.h"
+#include "MiceMen.h"
+#include "BoardBenchmark.h"
+#include "HAL/MemoryBase.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Misc/DateTime.h"
+#include "Misc/EngineVersion.h"
+
+// Forwards to the engine allocator, counting every allocation made while it is installed
+class FCountingMalloc final : public FMalloc
+{
+public:
+	explicit FCountingMalloc(FMalloc* InInner) : Inner(InInner), Allocations(0) {}
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		++Allocations;
+		return Inner->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		if (Count != 0)
+		{
+			++Allocations;
+		}
+		return Inner->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override { Inner->Free(Original); }
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+	virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+	virtual const TCHAR* GetDescriptiveName() override { return TEXT("CountingMalloc"); }
+
+	FMalloc* Inner;
+	TAtomic<int64> Allocations;
+};
+
+static FCountingMalloc* CountingMalloc = nullptr;
+
+static int64 CountAllocations()
+{
+	return CountingMalloc->Allocations.Load(EMemoryOrder::Relaxed);
+}
+
+UBoardBenchmarkCommandlet::UBoardBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UBoardBenchmarkCommandlet::Main(const FString& Params)
+{
+	int32 Seed = 1;
+	float SecondsPerCase = 0.5f;
+	FString Output = TEXT("BoardBenchmark.json");
+	FIntPoint LargeBoardSize(256, 256);
+	int32 LargeBoardMice = 4000;
+	FParse::Value(*Params, TEXT("seed="), Seed);
+	FParse::Value(*Params, TEXT("seconds="), SecondsPerCase);
+	FParse::Value(*Params, TEXT("output="), Output);
+	FParse::Value(*Params, TEXT("largewidth="), LargeBoardSize.X);
+	FParse::Value(*Params, TEXT("largeheight="), LargeBoardSize.Y);
+	FParse::Value(*Params, TEXT("largemice="), LargeBoardMice);
+	if (FPaths::IsRelative(Output))
+	{
+		Output = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / Output;
+	}
+
+	// Each team needs room for its mice on its half of the board, about half of which is cheese
+	LargeBoardSize.X = FMath::Max(LargeBoardSize.X, 3);
+	LargeBoardSize.Y = FMath::Max(LargeBoardSize.Y, 1);
+	LargeBoardMice = FMath::Clamp(LargeBoardMice, 0, LargeBoardSize.X / 2 * LargeBoardSize.Y / 4);
+
+	FBoardBenchmark Benchmark(Seed, FMath::Max(SecondsPerCase, 0.01f), &CountAllocations, LargeBoardSize, LargeBoardMice);
+	TArray<FBoardBenchmarkResult> Results;
+
+	// Blocks allocated while counting are freed by the engine allocator afterwards, both end up in the same heap
+	FMalloc* EngineMalloc = GMalloc;
+	CountingMalloc = new FCountingMalloc(EngineMalloc);
+	GMalloc = CountingMalloc;
+	Benchmark.Run(Results);
+	GMalloc = EngineMalloc;
+
+	FString Json = FString::Printf(TEXT("{\n\t\"version\": \"%s\",\n\t\"date\": \"%s\",\n\t\"seed\": %d,\n\t\"large_board\": [%d, %d, %d],\n\t\"results\": [\n"),
+		*FEngineVersion::Current().ToString(), *FDateTime::UtcNow().ToIso8601(), Seed, LargeBoardSize.X, LargeBoardSize.Y, LargeBoardMice);
+	for (int32 i = 0; i < Results.Num(); ++i)
+	{
+		const FBoardBenchmarkResult& Result = Results[i];
+		UE_LOG(LogMiceMen, Display, TEXT("%-16s %12.1f ns/op %8.3f allocs/op (%lld ops)"),
+			Result.Name, Result.NanosecondsPerOperation, Result.AllocationsPerOperation, Result.Operations);
+		Json += FString::Printf(TEXT("\t\t{ \"name\": \"%s\", \"ns_per_op\": %.2f, \"allocs_per_op\": %.4f, \"operations\": %lld }%s\n"),
+			Result.Name, Result.NanosecondsPerOperation, Result.AllocationsPerOperation, Result.Operations, i + 1 < Results.Num() ? TEXT(",") : TEXT(""));
+	}
+	Json += TEXT("\t]\n}\n");
+
+	if (!FFileHelper::SaveStringToFile(Json, *Output))
+	{
+		UE_LOG(LogMiceMen, Error, TEXT("BoardBenchmark: could not write %s"), *Output);
+		return 1;
+	}
+	UE_LOG(LogMiceMen, Display, TEXT("BoardBenchmark: results written to %s"), *Output);
+	return 0;
+}
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "BoardBenchmarkCommandlet.generated.h"
+
+/**
+ * Runs FBoardBenchmark and writes the results as JSON for tracking regressions between builds. Run with
+ * UE4Editor-Cmd MiceMen.uproject -run=BoardBenchmark -nullrhi -seed=1 -seconds=0.5 -output=Bench.json
+ * Relative output paths go to Saved/Benchmarks. The Large cases default to a 256x256 board with 4000 mice
+ * per team, set with -largewidth=, -largeheight= and -largemice=.
+ */
+UCLASS()
+class MICEMEN_API UBoardBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UBoardBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
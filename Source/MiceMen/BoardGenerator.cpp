@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BoardGenerator.h"
+#include "BoardSearch.h"
+#include "Async/ParallelFor.h"
+#include "Templates/Atomic.h"
+
+FBoardGenerator::FBoardGenerator(const FBoardGeneratorSettings& InSettings)
+	: Settings(InSettings)
+{
+}
+
+void FBoardGenerator::Build(const FRandomStream& Random, float CheeseDensity, FMatchState& OutState)
+{
+	OutState = FMatchState();
+	OutState.SideToMove = EBoardCell(Random.RandRange(1, 2));
+	FBoardState& Board = OutState.Board;
+
+	// Every third cell of the edge columns is always cheese
+	for (int32 y = 0; y < FBoardState::Height; y += 3)
+	{
+		Board.SetCell(0, y, EBoardCell::Cheese);
+		Board.SetCell(FBoardState::Width - 1, y, EBoardCell::Cheese);
+	}
+
+	// Each team deals its mice onto its half, red on the left and blue on the right with the middle column free of mice.
+	// A partial shuffle of the free cells picks them, every draw lands on a free cell
+	const EBoardCell Teams[2] = { EBoardCell::Red, EBoardCell::Blue };
+	const int32 FirstColumns[2] = { 0, FBoardState::Width / 2 + 1 };
+	int32 FreeCells[FBoardState::Width / 2 * FBoardState::Height];
+	for (int32 Team = 0; Team < 2; ++Team)
+	{
+		int32 NumFreeCells = 0;
+		for (int32 x = FirstColumns[Team]; x < FirstColumns[Team] + FBoardState::Width / 2; ++x)
+		{
+			for (int32 y = 0; y < FBoardState::Height; ++y)
+			{
+				if (Board.IsEmpty(x, y))
+				{
+					FreeCells[NumFreeCells++] = x * FBoardState::Height + y;
+				}
+			}
+		}
+		check(NumFreeCells >= FBoardState::MicePerTeam);
+
+		for (int32 i = 0; i < FBoardState::MicePerTeam; ++i)
+		{
+			Swap(FreeCells[i], FreeCells[Random.RandRange(i, NumFreeCells - 1)]);
+			Board.SetCell(FreeCells[i] / FBoardState::Height, FreeCells[i] % FBoardState::Height, Teams[Team]);
+		}
+	}
+
+	for (int32 x = 1; x < FBoardState::Width - 1; ++x)
+	{
+		for (int32 y = 0; y < FBoardState::Height; ++y)
+		{
+			if (Board.IsEmpty(x, y) && Random.GetFraction() < CheeseDensity)
+			{
+				Board.SetCell(x, y, EBoardCell::Cheese);
+			}
+		}
+	}
+
+	Board.Settle();
+	OutState.UpdateHash();
+}
+
+FBoardFairness FBoardGenerator::Evaluate(const FMatchState& State) const
+{
+	FBoardFairness Fairness;
+	const FBoardState& Board = State.Board;
+	Fairness.MobilityDifference = FMath::Abs(FMath::CountBits(Board.BlueColumns) - FMath::CountBits(Board.RedColumns));
+	Fairness.ImmediateGoals = Board.BlueScore + Board.RedScore;
+
+	// The start as if each team moved first, a team moving first has every column of its mice available
+	FMatchState TeamFirst[2] = { State, State };
+	TeamFirst[0].SideToMove = EBoardCell::Blue;
+	TeamFirst[1].SideToMove = EBoardCell::Red;
+	Fairness.MaterialDifference = FMath::Abs(FBoardSearch::Evaluate(TeamFirst[0]));
+
+	int32 SearchScores[2] = { 0, 0 };
+	for (int32 Team = 0; Team < 2; ++Team)
+	{
+		TeamFirst[Team].UpdateHash();
+		if (Settings.bNoImmediateGoals)
+		{
+			FBoardMove Moves[FMatchState::MaxMoves];
+			const int32 NumMoves = TeamFirst[Team].GetLegalMoves(Moves);
+			for (int32 i = 0; i < NumMoves; ++i)
+			{
+				FMatchState Child = TeamFirst[Team];
+				Child.ApplyMove(Moves[i]);
+				Fairness.ImmediateGoals += Child.Board.BlueScore + Child.Board.RedScore - Board.BlueScore - Board.RedScore;
+			}
+		}
+		if (Settings.SearchDepth > 0)
+		{
+			FBoardSearch Search;
+			SearchScores[Team] = Search.Search(TeamFirst[Team], TNumericLimits<double>::Max(), Settings.SearchDepth).Score;
+		}
+	}
+	Fairness.SearchDifference = FMath::Abs(SearchScores[0] - SearchScores[1]);
+
+	Fairness.Excess = FMath::Max(Fairness.MobilityDifference - Settings.MaxMobilityDifference, 0)
+		+ FMath::Max(Fairness.MaterialDifference - Settings.MaxMaterialDifference, 0)
+		+ (Settings.bNoImmediateGoals ? Fairness.ImmediateGoals : 0)
+		+ (Settings.SearchDepth > 0 ? FMath::Max(Fairness.SearchDifference - Settings.MaxSearchDifference, 0) : 0);
+	return Fairness;
+}
+
+bool FBoardGenerator::Generate(int32 Seed, FMatchState& OutState, FBoardFairness* OutFairness) const
+{
+	FBoardFairness Best;
+	FMatchState Candidate;
+	for (int32 Attempt = 0; Attempt < FMath::Max(Settings.MaxAttempts, 1); ++Attempt)
+	{
+		// The first draw uses the seed itself, later ones a stream derived from it so every seed has its own sequence
+		const FRandomStream Random(Attempt == 0 ? Seed : int32(HashCombine(uint32(Seed), uint32(Attempt))));
+		Build(Random, Settings.CheeseDensity, Candidate);
+		const FBoardFairness Fairness = Evaluate(Candidate);
+		if (Attempt == 0 || Fairness.Excess < Best.Excess)
+		{
+			Best = Fairness;
+			OutState = Candidate;
+			if (Best.IsAccepted())
+			{
+				break;
+			}
+		}
+	}
+
+	if (OutFairness != nullptr)
+	{
+		*OutFairness = Best;
+	}
+	return Best.IsAccepted();
+}
+
+int32 FBoardGenerator::GenerateBatch(const TArray<int32>& Seeds, TArray<FMatchState>& OutStates, TArray<FBoardFairness>* OutFairness, bool bSingleThreaded) const
+{
+	// Every match writes its own slot, so workers share nothing but the count
+	OutStates.SetNum(Seeds.Num());
+	TArray<FBoardFairness> Fairness;
+	Fairness.SetNum(Seeds.Num());
+	TAtomic<int32> NumAccepted(0);
+	ParallelFor(Seeds.Num(), [this, &Seeds, &OutStates, &Fairness, &NumAccepted](int32 Index)
+	{
+		if (Generate(Seeds[Index], OutStates[Index], &Fairness[Index]))
+		{
+			++NumAccepted;
+		}
+	}, bSingleThreaded);
+
+	if (OutFairness != nullptr)
+	{
+		*OutFairness = MoveTemp(Fairness);
+	}
+	return NumAccepted.Load();
+}
@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MatchState.h"
+
+// What a generated match has to satisfy to be played
+struct FBoardGeneratorSettings
+{
+	// Chance of each inner cell left free by the mice holding cheese, the edge columns always hold every third cell
+	float CheeseDensity = 0.5f;
+
+	// Largest difference between the number of columns each team can move
+	int32 MaxMobilityDifference = 1;
+
+	// Largest static evaluation of the start, see FBoardSearch::Evaluate: how much closer one team's mice are to their goal
+	int32 MaxMaterialDifference = 8;
+
+	// No goal may be scored while the board settles, nor by any first move of either team
+	bool bNoImmediateGoals = true;
+
+	// Depth of the search run from the start once with each team moving first, zero skips it
+	int32 SearchDepth = 2;
+
+	// Largest difference between the two search scores, so moving first is about as good for both teams
+	int32 MaxSearchDifference = 16;
+
+	// Boards drawn for a seed before the fairest of them is taken anyway
+	int32 MaxAttempts = 64;
+};
+
+// How a match measures against FBoardGeneratorSettings
+struct FBoardFairness
+{
+	int32 MobilityDifference = 0;
+	int32 MaterialDifference = 0;
+	int32 ImmediateGoals = 0;
+	int32 SearchDifference = 0;
+
+	// How far the limits were exceeded in total, zero when the match is accepted
+	int32 Excess = 0;
+
+	bool IsAccepted() const { return Excess == 0; }
+};
+
+/**
+ * Builds starting positions without rejection loops and keeps only fair ones. Mice are dealt onto
+ * cells drawn from the list of free cells of their half, then cheese fills the rest by density, so
+ * every draw places every piece in one pass. Each candidate is settled and checked headlessly:
+ * balanced mobility and distance to the goals, no goals before the first real move, and a short search
+ * with either team moving first. The same seed always gives the same match, so seeds can still be
+ * shared and replayed.
+ */
+class MICEMEN_API FBoardGenerator
+{
+public:
+	explicit FBoardGenerator(const FBoardGeneratorSettings& InSettings = FBoardGeneratorSettings());
+
+	// Pick the first team, deal the mice and cheese from the stream and settle the board
+	static void Build(const FRandomStream& Random, float CheeseDensity, FMatchState& OutState);
+
+	FBoardFairness Evaluate(const FMatchState& State) const;
+
+	// Draw matches for the seed until one is accepted or MaxAttempts were drawn, in which case the fairest is
+	// returned. Returns whether the match was accepted
+	bool Generate(int32 Seed, FMatchState& OutState, FBoardFairness* OutFairness = nullptr) const;
+
+	// One match per seed, spread over the worker threads. Returns how many were accepted
+	int32 GenerateBatch(const TArray<int32>& Seeds, TArray<FMatchState>& OutStates, TArray<FBoardFairness>* OutFairness = nullptr, bool bSingleThreaded = false) const;
+
+	const FBoardGeneratorSettings& GetSettings() const { return Settings; }
+
+private:
+	FBoardGeneratorSettings Settings;
+};
@@ -0,0 +1,276 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BoardSearch.h"
+#include "TranspositionTable.h"
+#include "HAL/PlatformTime.h"
+
+constexpr int32 FBoardSearch::WinScore;
+constexpr int32 FBoardSearch::MaxDepth;
+
+// Value of a mouse that reached its goal, higher than any mouse still on the board
+static const int32 GoalValue = 64;
+
+FBoardSearch::FBoardSearch(FTranspositionTable* InTable, bool bInNewTableSearch)
+	: Table(InTable)
+	, bNewTableSearch(bInNewTableSearch)
+	, TableProbes(0)
+	, TableHits(0)
+	, Deadline(0.0)
+	, CancelFlag(nullptr)
+	, bAborted(false)
+	, Nodes(0)
+{
+	FMemory::Memzero(HistoryScores);
+}
+
+FBoardSearchResult FBoardSearch::Search(const FMatchState& Root, double TimeBudgetSeconds, int32 DepthLimit)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	FBoardSearchResult Result;
+
+	FBoardMove Moves[FMatchState::MaxMoves];
+	const int32 NumMoves = Root.GetLegalMoves(Moves);
+	if (Root.IsFinished() || NumMoves == 0)
+	{
+		// Nothing to search, the score is still filled in for callers ranking positions
+		Result.Score = Root.IsFinished() ? ScoreResult(Root, 0) : Evaluate(Root);
+		return Result;
+	}
+
+	FMemory::Memzero(HistoryScores);
+	Nodes = 0;
+	TableProbes = 0;
+	TableHits = 0;
+	bAborted = false;
+	if (Table != nullptr && bNewTableSearch)
+	{
+		Table->NewSearch();
+	}
+	RootBestMove = FBoardMove();
+	Result.BestMove = Moves[0];
+
+	// Static score, only kept when the depth limit is zero
+	Result.Score = Evaluate(Root);
+
+	for (int32 Depth = 1; Depth <= FMath::Min(DepthLimit, MaxDepth); ++Depth)
+	{
+		// The first iteration always completes so there is a searched move to play
+		Deadline = Depth == 1 ? TNumericLimits<double>::Max() : StartTime + TimeBudgetSeconds;
+
+		const int32 Score = AlphaBeta(Root, Depth, 0, -WinScore - 1, WinScore + 1);
+		if (bAborted)
+		{
+			break;
+		}
+
+		Result.BestMove = RootBestMove;
+		Result.Score = Score;
+		Result.Depth = Depth;
+		if (OnIteration)
+		{
+			Result.Nodes = Nodes;
+			Result.Seconds = FPlatformTime::Seconds() - StartTime;
+			OnIteration(Result);
+		}
+
+		// Stop early once the outcome is forced or time is nearly up, the next iteration would not finish anyway
+		if (FMath::Abs(Score) >= WinScore - MaxDepth || FPlatformTime::Seconds() - StartTime >= TimeBudgetSeconds * 0.5)
+		{
+			break;
+		}
+	}
+
+	Result.Nodes = Nodes;
+	Result.TableProbes = TableProbes;
+	Result.TableHits = TableHits;
+	if (Table != nullptr)
+	{
+		Table->AddStats(TableProbes, TableHits);
+	}
+	Result.Seconds = FPlatformTime::Seconds() - StartTime;
+	return Result;
+}
+
+int32 FBoardSearch::Evaluate(const FMatchState& State)
+{
+	// Every mouse is worth more the closer it is to its goal
+	int32 BlueValue = State.Board.BlueScore * GoalValue;
+	int32 RedValue = State.Board.RedScore * GoalValue;
+	for (int32 x = 0; x < FBoardState::Width; ++x)
+	{
+		BlueValue += FMath::CountBits(State.Board.BlueMice[x]) * (FBoardState::Width - x);
+		RedValue += FMath::CountBits(State.Board.RedMice[x]) * (x + 1);
+	}
+	return State.SideToMove == EBoardCell::Blue ? BlueValue - RedValue : RedValue - BlueValue;
+}
+
+int32 FBoardSearch::AlphaBeta(const FMatchState& State, int32 Depth, int32 Ply, int32 Alpha, int32 Beta)
+{
+	++Nodes;
+	if (State.IsFinished())
+	{
+		return ScoreResult(State, Ply);
+	}
+	if (Depth == 0)
+	{
+		return Evaluate(State);
+	}
+	if (IsOutOfTime())
+	{
+		return 0;
+	}
+
+	const int32 OriginalAlpha = Alpha;
+	FBoardMove TableMove;
+	if (Table != nullptr)
+	{
+		++TableProbes;
+		FTranspositionEntry Entry;
+		if (Table->Probe(State.GetHash(), Entry))
+		{
+			++TableHits;
+			TableMove = Entry.Move;
+
+			// The root always searches so it has a best move to report
+			if (Ply > 0 && Entry.Depth >= Depth)
+			{
+				const int32 Score = ScoreFromTable(Entry.Score, Ply);
+				if (Entry.Bound == ETranspositionBound::Exact
+					|| (Entry.Bound == ETranspositionBound::Lower && Score >= Beta)
+					|| (Entry.Bound == ETranspositionBound::Upper && Score <= Alpha))
+				{
+					return Score;
+				}
+			}
+		}
+	}
+
+	FBoardMove Moves[FMatchState::MaxMoves];
+	const int32 NumMoves = State.GetLegalMoves(Moves);
+	if (NumMoves == 0)
+	{
+		return Evaluate(State);
+	}
+	OrderMoves(Moves, NumMoves, Ply == 0 && RootBestMove.IsValid() ? RootBestMove : TableMove);
+
+	int32 BestScore = -WinScore - 1;
+	FBoardMove BestMove;
+	for (int32 i = 0; i < NumMoves; ++i)
+	{
+		FMatchState Child = State;
+		Child.ApplyMove(Moves[i]);
+		const int32 Score = -AlphaBeta(Child, Depth - 1, Ply + 1, -Beta, -Alpha);
+		if (bAborted)
+		{
+			return 0;
+		}
+
+		if (Score > BestScore)
+		{
+			BestScore = Score;
+			BestMove = Moves[i];
+		}
+		if (Score > Alpha)
+		{
+			Alpha = Score;
+		}
+		if (Alpha >= Beta)
+		{
+			HistoryScores[Moves[i].Encode()] += Depth * Depth;
+			break;
+		}
+	}
+
+	if (Ply == 0)
+	{
+		RootBestMove = BestMove;
+	}
+	if (Table != nullptr)
+	{
+		const ETranspositionBound Bound = BestScore <= OriginalAlpha ? ETranspositionBound::Upper
+			: BestScore >= Beta ? ETranspositionBound::Lower : ETranspositionBound::Exact;
+		Table->Store(State.GetHash(), ScoreToTable(BestScore, Ply), Depth, Bound, BestMove);
+	}
+	return BestScore;
+}
+
+int32 FBoardSearch::ScoreResult(const FMatchState& State, int32 Ply) const
+{
+	const EMatchResult MatchResult = State.GetResult();
+	if (MatchResult == EMatchResult::Draw)
+	{
+		return 0;
+	}
+
+	// Prefer quicker wins and slower losses
+	const bool bSideToMoveWon = (MatchResult == EMatchResult::BlueWins) == (State.SideToMove == EBoardCell::Blue);
+	return bSideToMoveWon ? WinScore - Ply : -WinScore + Ply;
+}
+
+int32 FBoardSearch::ScoreToTable(int32 Score, int32 Ply)
+{
+	if (Score >= WinScore - MaxDepth)
+	{
+		return Score + Ply;
+	}
+	if (Score <= -WinScore + MaxDepth)
+	{
+		return Score - Ply;
+	}
+	return Score;
+}
+
+int32 FBoardSearch::ScoreFromTable(int32 Score, int32 Ply)
+{
+	if (Score >= WinScore - MaxDepth)
+	{
+		return Score - Ply;
+	}
+	if (Score <= -WinScore + MaxDepth)
+	{
+		return Score + Ply;
+	}
+	return Score;
+}
+
+void FBoardSearch::OrderMoves(FBoardMove* Moves, int32 NumMoves, FBoardMove FirstMove) const
+{
+	int32 Start = 0;
+	if (FirstMove.IsValid())
+	{
+		for (int32 i = 0; i < NumMoves; ++i)
+		{
+			if (Moves[i] == FirstMove)
+			{
+				Swap(Moves[0], Moves[i]);
+				Start = 1;
+				break;
+			}
+		}
+	}
+
+	// Insertion sort, there are never more than MaxMoves moves
+	for (int32 i = Start + 1; i < NumMoves; ++i)
+	{
+		const FBoardMove Move = Moves[i];
+		const int32 MoveScore = HistoryScores[Move.Encode()];
+		int32 j = i - 1;
+		while (j >= Start && HistoryScores[Moves[j].Encode()] < MoveScore)
+		{
+			Moves[j + 1] = Moves[j];
+			--j;
+		}
+		Moves[j + 1] = Move;
+	}
+}
+
+bool FBoardSearch::IsOutOfTime()
+{
+	// Reading the clock is comparatively slow, only do it every few nodes
+	if (!bAborted && (Nodes & 1023) == 0 && ((CancelFlag != nullptr && CancelFlag->Load()) || FPlatformTime::Seconds() >= Deadline))
+	{
+		bAborted = true;
+	}
+	return bAborted;
+}
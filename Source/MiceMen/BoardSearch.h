@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MatchState.h"
+#include "Templates/Atomic.h"
+#include "Templates/Function.h"
+
+class FTranspositionTable;
+
+struct FBoardSearchResult
+{
+	FBoardMove BestMove;
+
+	// Score of BestMove from the point of view of the side to move
+	int32 Score = 0;
+
+	// Deepest fully searched iteration
+	int32 Depth = 0;
+	int64 Nodes = 0;
+	double Seconds = 0.0;
+
+	// Transposition table probes and how many of them found the position
+	int64 TableProbes = 0;
+	int64 TableHits = 0;
+};
+
+/**
+ * Computer opponent working on FMatchState. Runs an alpha-beta search with iterative deepening
+ * until the time budget runs out, so it plays stronger the more time it is given.
+ * An optional transposition table, which may be shared with other searches, remembers
+ * positions reached through different move orders and across iterations.
+ */
+class MICEMEN_API FBoardSearch
+{
+public:
+	static constexpr int32 WinScore = 1000000;
+	static constexpr int32 MaxDepth = 64;
+
+	// Every search starts a new table generation unless bInNewTableSearch is false, searches running
+	// side by side on a shared table leave that to whoever starts them
+	explicit FBoardSearch(FTranspositionTable* InTable = nullptr, bool bInNewTableSearch = true);
+
+	FBoardSearchResult Search(const FMatchState& Root, double TimeBudgetSeconds, int32 DepthLimit = MaxDepth);
+
+	// Stop as soon as the flag is set from any thread, even during the first iteration. It must outlive the search
+	void SetCancelFlag(const TAtomic<bool>* Flag) { CancelFlag = Flag; }
+
+	// Called on the searching thread after every completed iteration with the result so far
+	void SetIterationCallback(TFunction<void(const FBoardSearchResult&)> Callback) { OnIteration = MoveTemp(Callback); }
+
+	// Static score of a position for the side to move
+	static int32 Evaluate(const FMatchState& State);
+
+private:
+	int32 AlphaBeta(const FMatchState& State, int32 Depth, int32 Ply, int32 Alpha, int32 Beta);
+	int32 ScoreResult(const FMatchState& State, int32 Ply) const;
+
+	// Win scores depend on the ply they were found at, the table keeps them relative to the stored position
+	static int32 ScoreToTable(int32 Score, int32 Ply);
+	static int32 ScoreFromTable(int32 Score, int32 Ply);
+
+	// Put FirstMove in front, then sort the rest by history score
+	void OrderMoves(FBoardMove* Moves, int32 NumMoves, FBoardMove FirstMove) const;
+	bool IsOutOfTime();
+
+	// How often each move caused a cutoff, indexed by encoded move
+	int32 HistoryScores[FMatchState::MaxMoves];
+
+	FTranspositionTable* Table;
+	bool bNewTableSearch;
+	int64 TableProbes;
+	int64 TableHits;
+
+	double Deadline;
+	const TAtomic<bool>* CancelFlag;
+	TFunction<void(const FBoardSearchResult&)> OnIteration;
+	bool bAborted;
+	int64 Nodes;
+	FBoardMove RootBestMove;
+};
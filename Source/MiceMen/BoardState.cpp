@@ -0,0 +1,446 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BoardState.h"
+#include "Zobrist.h"
+
+#define BOARD_TEMPLATE template<int32 InWidth, int32 InHeight, int32 InMicePerTeam>
+#define BOARD_STATE TBoardState<InWidth, InHeight, InMicePerTeam>
+
+// Zobrist keys of the board size
+#define BOARD_KEYS TBoardZobristKeys<InWidth, InHeight, InMicePerTeam>
+
+BOARD_TEMPLATE constexpr int32 BOARD_STATE::Width;
+BOARD_TEMPLATE constexpr int32 BOARD_STATE::Height;
+BOARD_TEMPLATE constexpr int32 BOARD_STATE::MicePerTeam;
+BOARD_TEMPLATE constexpr int32 BOARD_STATE::BlueGoal;
+BOARD_TEMPLATE constexpr int32 BOARD_STATE::RedGoal;
+BOARD_TEMPLATE constexpr typename BOARD_STATE::FColumn BOARD_STATE::ColumnMask;
+BOARD_TEMPLATE constexpr typename BOARD_STATE::FColumnSet BOARD_STATE::AllColumns;
+
+BOARD_TEMPLATE
+BOARD_STATE::TBoardState()
+{
+	Reset();
+}
+
+BOARD_TEMPLATE
+void BOARD_STATE::Reset()
+{
+	FMemory::Memzero(Cheese);
+	FMemory::Memzero(BlueMice);
+	FMemory::Memzero(RedMice);
+	BlueColumns = 0;
+	RedColumns = 0;
+	BlueScore = 0;
+	RedScore = 0;
+	Hash = ComputeHash();
+}
+
+BOARD_TEMPLATE
+void BOARD_STATE::GenerateCheese(const FRandomStream& Random)
+{
+	for (int32 x = 0; x < Width; ++x)
+	{
+		for (int32 y = 0; y < Height; ++y)
+		{
+			if (x == 0 || x == Width - 1)
+			{
+				if (y % 3 == 0)
+				{
+					SetCell(x, y, EBoardCell::Cheese);
+				}
+			}
+			else if (Random.RandRange(0, 1) != 0)
+			{
+				SetCell(x, y, EBoardCell::Cheese);
+			}
+		}
+	}
+}
+
+BOARD_TEMPLATE
+void BOARD_STATE::GenerateMice(const FRandomStream& Random)
+{
+	// Each team starts on the half away from its goal, the middle column stays free of mice
+	const EBoardCell Teams[2] = { EBoardCell::Red, EBoardCell::Blue };
+	const int32 FirstColumns[2] = { 0, Width / 2 + 1 };
+	for (int32 Team = 0; Team < 2; ++Team)
+	{
+		int32 NumberOfMice = MicePerTeam;
+		while (NumberOfMice > 0)
+		{
+			const int32 x = Random.RandRange(FirstColumns[Team], FirstColumns[Team] + Width / 2 - 1);
+			const int32 y = Random.RandRange(0, Height - 1);
+			if (IsEmpty(x, y))
+			{
+				SetCell(x, y, Teams[Team]);
+				--NumberOfMice;
+			}
+		}
+	}
+}
+
+BOARD_TEMPLATE
+bool BOARD_STATE::IsInside(int32 X, int32 Y) const
+{
+	return X >= 0 && X < Width && Y >= 0 && Y < Height;
+}
+
+BOARD_TEMPLATE
+bool BOARD_STATE::IsEmpty(int32 X, int32 Y) const
+{
+	return IsInside(X, Y) && (GetOccupied(X) & (FColumn(1) << Y)) == 0;
+}
+
+BOARD_TEMPLATE
+EBoardCell BOARD_STATE::GetCell(int32 X, int32 Y) const
+{
+	if (IsInside(X, Y))
+	{
+		const FColumn Bit = FColumn(FColumn(1) << Y);
+		if (Cheese[X] & Bit)
+		{
+			return EBoardCell::Cheese;
+		}
+		if (BlueMice[X] & Bit)
+		{
+			return EBoardCell::Blue;
+		}
+		if (RedMice[X] & Bit)
+		{
+			return EBoardCell::Red;
+		}
+	}
+	return EBoardCell::Empty;
+}
+
+BOARD_TEMPLATE
+void BOARD_STATE::SetCell(int32 X, int32 Y, EBoardCell Cell)
+{
+	check(IsInside(X, Y));
+	const BOARD_KEYS& Keys = BOARD_KEYS::Get();
+	const EBoardCell OldCell = GetCell(X, Y);
+	if (OldCell != EBoardCell::Empty)
+	{
+		Hash ^= Keys.Piece(OldCell, X, Y);
+	}
+	if (Cell != EBoardCell::Empty)
+	{
+		Hash ^= Keys.Piece(Cell, X, Y);
+	}
+
+	const FColumn Bit = FColumn(FColumn(1) << Y);
+	Cheese[X] &= FColumn(~Bit);
+	BlueMice[X] &= FColumn(~Bit);
+	RedMice[X] &= FColumn(~Bit);
+	switch (Cell)
+	{
+	case EBoardCell::Cheese:
+		Cheese[X] |= Bit;
+		break;
+	case EBoardCell::Blue:
+		BlueMice[X] |= Bit;
+		break;
+	case EBoardCell::Red:
+		RedMice[X] |= Bit;
+		break;
+	default:
+		break;
+	}
+
+	const FColumnSet ColumnBit = FColumnSet(1) << X;
+	BlueColumns = BlueMice[X] != 0 ? BlueColumns | ColumnBit : BlueColumns & ~ColumnBit;
+	RedColumns = RedMice[X] != 0 ? RedColumns | ColumnBit : RedColumns & ~ColumnBit;
+}
+
+BOARD_TEMPLATE
+typename BOARD_STATE::FColumn BOARD_STATE::GetOccupied(int32 X) const
+{
+	if (X < 0 || X >= Width)
+	{
+		return 0;
+	}
+	return FColumn(Cheese[X] | BlueMice[X] | RedMice[X]);
+}
+
+BOARD_TEMPLATE
+typename BOARD_STATE::FColumn BOARD_STATE::GetMice(int32 X) const
+{
+	if (X < 0 || X >= Width)
+	{
+		return 0;
+	}
+	return FColumn(BlueMice[X] | RedMice[X]);
+}
+
+// Rotate a single column mask, the top row wraps to the bottom when moving up and vice versa
+BOARD_TEMPLATE
+typename BOARD_STATE::FColumn BOARD_STATE::RotateColumn(FColumn Column, bool bUpward)
+{
+	if (bUpward)
+	{
+		return FColumn(((Column << 1) | (Column >> (Height - 1))) & ColumnMask);
+	}
+	return FColumn(((Column >> 1) | (Column << (Height - 1))) & ColumnMask);
+}
+
+// Toggle the keys of every piece of a column mask
+template<typename KeysType>
+static FORCEINLINE uint64 HashColumn(const KeysType& Keys, EBoardCell Cell, int32 X, uint64 Mask)
+{
+	uint64 ColumnHash = 0;
+	for (; Mask != 0; Mask &= Mask - 1)
+	{
+		ColumnHash ^= Keys.Piece(Cell, X, FBoardState::LowestBit(Mask));
+	}
+	return ColumnHash;
+}
+
+BOARD_TEMPLATE
+void BOARD_STATE::MoveColumn(int32 X, bool bUpward)
+{
+	check(X >= 0 && X < Width);
+	const BOARD_KEYS& Keys = BOARD_KEYS::Get();
+	Hash ^= HashColumn(Keys, EBoardCell::Cheese, X, Cheese[X]) ^ HashColumn(Keys, EBoardCell::Blue, X, BlueMice[X]) ^ HashColumn(Keys, EBoardCell::Red, X, RedMice[X]);
+	Cheese[X] = RotateColumn(Cheese[X], bUpward);
+	BlueMice[X] = RotateColumn(BlueMice[X], bUpward);
+	RedMice[X] = RotateColumn(RedMice[X], bUpward);
+	Hash ^= HashColumn(Keys, EBoardCell::Cheese, X, Cheese[X]) ^ HashColumn(Keys, EBoardCell::Blue, X, BlueMice[X]) ^ HashColumn(Keys, EBoardCell::Red, X, RedMice[X]);
+}
+
+BOARD_TEMPLATE
+typename BOARD_STATE::FColumn BOARD_STATE::GetMovableMice(int32 X) const
+{
+	// A mouse falls when the cell below is free, bit 0 is the bottom so it can never fall
+	const uint64 Falling = uint64(GetMice(X)) & ~(uint64(GetOccupied(X)) << 1) & ~uint64(1);
+	const uint64 BlueWalking = BlueMice[X] & ~uint64(GetOccupied(X - 1));
+	const uint64 RedWalking = RedMice[X] & ~uint64(GetOccupied(X + 1));
+	return FColumn((Falling | BlueWalking | RedWalking) & ColumnMask);
+}
+
+BOARD_TEMPLATE
+bool BOARD_STATE::MakeStep(int32 X, int32 Y, FBoardStep& OutStep) const
+{
+	const EBoardCell Mouse = GetCell(X, Y);
+	if (Mouse != EBoardCell::Blue && Mouse != EBoardCell::Red)
+	{
+		return false;
+	}
+
+	OutStep.From = FIntPoint(X, Y);
+	OutStep.Mouse = Mouse;
+	if (Y > 0 && (GetOccupied(X) & (FColumn(1) << (Y - 1))) == 0)
+	{
+		OutStep.To = FIntPoint(X, Y - 1);
+		return true;
+	}
+
+	const int32 AheadX = Mouse == EBoardCell::Blue ? X - 1 : X + 1;
+	if ((GetOccupied(AheadX) & (FColumn(1) << Y)) == 0)
+	{
+		OutStep.To = FIntPoint(AheadX, Y);
+		return true;
+	}
+	return false;
+}
+
+BOARD_TEMPLATE
+bool BOARD_STATE::FindStep(FBoardStep& OutStep) const
+{
+	int32 BestX = INDEX_NONE;
+	int32 BestY = Height;
+	for (int32 x = 0; x < Width; ++x)
+	{
+		const FColumn Movable = GetMovableMice(x);
+		if (Movable != 0)
+		{
+			const int32 y = LowestBit(Movable);
+			if (y < BestY)
+			{
+				BestX = x;
+				BestY = y;
+			}
+		}
+	}
+	return BestX != INDEX_NONE && MakeStep(BestX, BestY, OutStep);
+}
+
+BOARD_TEMPLATE
+void BOARD_STATE::ApplyStep(const FBoardStep& Step)
+{
+	SetCell(Step.From.X, Step.From.Y, EBoardCell::Empty);
+	if (IsGoalColumn(Step.To.X))
+	{
+		const BOARD_KEYS& Keys = BOARD_KEYS::Get();
+		if (Step.Mouse == EBoardCell::Blue)
+		{
+			Hash ^= Keys.BlueScore[BlueScore] ^ Keys.BlueScore[BlueScore + 1];
+			BlueScore++;
+		}
+		else
+		{
+			Hash ^= Keys.RedScore[RedScore] ^ Keys.RedScore[RedScore + 1];
+			RedScore++;
+		}
+	}
+	else
+	{
+		SetCell(Step.To.X, Step.To.Y, Step.Mouse);
+	}
+}
+
+BOARD_TEMPLATE
+void BOARD_STATE::UndoStep(const FBoardStep& Step)
+{
+	if (IsGoalColumn(Step.To.X))
+	{
+		const BOARD_KEYS& Keys = BOARD_KEYS::Get();
+		if (Step.Mouse == EBoardCell::Blue)
+		{
+			BlueScore--;
+			Hash ^= Keys.BlueScore[BlueScore] ^ Keys.BlueScore[BlueScore + 1];
+		}
+		else
+		{
+			RedScore--;
+			Hash ^= Keys.RedScore[RedScore] ^ Keys.RedScore[RedScore + 1];
+		}
+	}
+	else
+	{
+		SetCell(Step.To.X, Step.To.Y, EBoardCell::Empty);
+	}
+	SetCell(Step.From.X, Step.From.Y, Step.Mouse);
+}
+
+BOARD_TEMPLATE
+int32 BOARD_STATE::Settle(FColumnSet DirtyColumns)
+{
+	return SettleColumns(DirtyColumns, nullptr);
+}
+
+BOARD_TEMPLATE
+int32 BOARD_STATE::Settle(TArray<FBoardStep>& OutSteps, FColumnSet DirtyColumns)
+{
+	return SettleColumns(DirtyColumns, &OutSteps);
+}
+
+BOARD_TEMPLATE
+int32 BOARD_STATE::SettleColumns(FColumnSet DirtyColumns, TArray<FBoardStep>* OutSteps)
+{
+	int32 Steps = 0;
+
+	// Movable mice per column, only refreshed for dirty columns. MovableColumns has bit X set while column X has a movable mouse
+	FColumn Movable[Width] = {};
+	FColumnSet MovableColumns = 0;
+	DirtyColumns &= AllColumns;
+
+	for (;;)
+	{
+		while (DirtyColumns != 0)
+		{
+			const int32 x = LowestBit(DirtyColumns);
+			DirtyColumns &= DirtyColumns - 1;
+			Movable[x] = GetMovableMice(x);
+			if (Movable[x] != 0)
+			{
+				MovableColumns |= FColumnSet(1) << x;
+			}
+			else
+			{
+				MovableColumns &= ~(FColumnSet(1) << x);
+			}
+		}
+
+		if (MovableColumns == 0)
+		{
+			break;
+		}
+
+		// Lowest row first, then leftmost column, matching a bottom-up row scan of the board
+		int32 BestX = INDEX_NONE;
+		int32 BestY = Height;
+		for (FColumnSet Columns = MovableColumns; Columns != 0; Columns &= Columns - 1)
+		{
+			const int32 x = LowestBit(Columns);
+			const int32 y = LowestBit(Movable[x]);
+			if (y < BestY)
+			{
+				BestX = x;
+				BestY = y;
+			}
+		}
+
+		FBoardStep Step;
+		verify(MakeStep(BestX, BestY, Step));
+		ApplyStep(Step);
+		if (OutSteps != nullptr)
+		{
+			OutSteps->Add(Step);
+		}
+		++Steps;
+		DirtyColumns = (GetNeighbourColumns(Step.From.X) | GetNeighbourColumns(Step.To.X)) & AllColumns;
+	}
+	return Steps;
+}
+
+BOARD_TEMPLATE
+typename BOARD_STATE::FColumnSet BOARD_STATE::GetNeighbourColumns(int32 X)
+{
+	FColumnSet Columns = 0;
+	for (int32 x = X - 1; x <= X + 1; ++x)
+	{
+		if (x >= 0 && x < Width)
+		{
+			Columns |= FColumnSet(1) << x;
+		}
+	}
+	return Columns;
+}
+
+BOARD_TEMPLATE
+void BOARD_STATE::GetColumnList(FColumnSet Columns, TArray<int32>& OutColumns)
+{
+	for (; Columns != 0; Columns &= Columns - 1)
+	{
+		OutColumns.Add(LowestBit(Columns));
+	}
+}
+
+BOARD_TEMPLATE
+int32 BOARD_STATE::CountMice(EBoardCell Team) const
+{
+	const FColumn* TeamMice = Team == EBoardCell::Blue ? BlueMice : RedMice;
+	int32 Count = 0;
+	for (int32 x = 0; x < Width; ++x)
+	{
+		Count += FMath::CountBits(TeamMice[x]);
+	}
+	return Count;
+}
+
+BOARD_TEMPLATE
+bool BOARD_STATE::IsGoalColumn(int32 X)
+{
+	return X == BlueGoal || X == RedGoal;
+}
+
+BOARD_TEMPLATE
+uint64 BOARD_STATE::ComputeHash() const
+{
+	const BOARD_KEYS& Keys = BOARD_KEYS::Get();
+	uint64 NewHash = Keys.BlueScore[BlueScore] ^ Keys.RedScore[RedScore];
+	for (int32 x = 0; x < Width; ++x)
+	{
+		NewHash ^= HashColumn(Keys, EBoardCell::Cheese, x, Cheese[x]) ^ HashColumn(Keys, EBoardCell::Blue, x, BlueMice[x]) ^ HashColumn(Keys, EBoardCell::Red, x, RedMice[x]);
+	}
+	return NewHash;
+}
+
+#undef BOARD_KEYS
+#undef BOARD_STATE
+#undef BOARD_TEMPLATE
+
+// Every board size in use, other sizes up to 64x64 only need a line here
+template struct TBoardState<19, 13, 12>;
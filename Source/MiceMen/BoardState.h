@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Contents of a board cell. Values match EType so they can be converted directly
+enum class EBoardCell : uint8
+{
+	Cheese = 0,
+	Blue = 1,
+	Red = 2,
+	Empty = 3
+};
+
+// A single mouse movement, either one cell down, one cell ahead or out through a goal
+struct FBoardStep
+{
+	FIntPoint From;
+	FIntPoint To;
+	EBoardCell Mouse;
+};
+
+// Smallest unsigned type holding one bit per row of a column
+template<int32 Height>
+struct TBoardColumnType
+{
+	static_assert(Height > 0 && Height <= 64, "Columns are single masks, use FLargeBoardState for taller boards");
+	typedef typename TChooseClass<(Height <= 16), uint16, typename TChooseClass<(Height <= 32), uint32, uint64>::Result>::Result Type;
+};
+
+/**
+ * Engine independent game board. Every piece type is stored as a bitboard made of one
+ * Height bit mask per column, where bit 0 is the bottom row. Blue mice walk towards column -1
+ * and red mice towards column Width, leaving the board when they get there.
+ *
+ * The dimensions are compile time parameters so masks use the smallest integer types and every
+ * loop has a constant trip count: the classic 19x13 board packs a column in 16 bits and a set of
+ * columns in 32 bits. Boards up to 64x64 can be instantiated the same way at the end of
+ * BoardState.cpp, larger ones use FLargeBoardState.
+ */
+template<int32 InWidth, int32 InHeight, int32 InMicePerTeam>
+struct TBoardState
+{
+	static_assert(InWidth > 2 && InWidth <= 64, "Sets of columns are single masks, use FLargeBoardState for wider boards");
+
+	// One bit per row of a column
+	typedef typename TBoardColumnType<InHeight>::Type FColumn;
+	// One bit per column of the board
+	typedef typename TChooseClass<(InWidth <= 32), uint32, uint64>::Result FColumnSet;
+
+	static constexpr int32 Width = InWidth;
+	static constexpr int32 Height = InHeight;
+	static constexpr int32 MicePerTeam = InMicePerTeam;
+	static constexpr int32 BlueGoal = -1;
+	static constexpr int32 RedGoal = Width;
+	static constexpr FColumn ColumnMask = FColumn(FColumn(~FColumn(0)) >> (sizeof(FColumn) * 8 - Height));
+	static constexpr FColumnSet AllColumns = FColumnSet(FColumnSet(~FColumnSet(0)) >> (sizeof(FColumnSet) * 8 - Width));
+
+	TBoardState();
+
+	// Remove every piece and reset scores
+	void Reset();
+
+	// Place cheese on an empty board: every third cell of the edge columns and about half of the other cells
+	void GenerateCheese(const FRandomStream& Random);
+
+	// Place MicePerTeam mice of each team on random free cells, red on the left half and blue on the right half
+	void GenerateMice(const FRandomStream& Random);
+
+	bool IsInside(int32 X, int32 Y) const;
+	bool IsEmpty(int32 X, int32 Y) const;
+	EBoardCell GetCell(int32 X, int32 Y) const;
+	void SetCell(int32 X, int32 Y, EBoardCell Cell);
+
+	// Occupied cells of a column, goal columns are always free
+	FColumn GetOccupied(int32 X) const;
+	FColumn GetMice(int32 X) const;
+
+	// Rotate a column one cell up or down, wrapping around the edge
+	void MoveColumn(int32 X, bool bUpward);
+
+	// Mice of a column that can either fall or walk
+	FColumn GetMovableMice(int32 X) const;
+
+	// Build the step the mouse at X, Y would take, falling has priority over walking
+	bool MakeStep(int32 X, int32 Y, FBoardStep& OutStep) const;
+
+	// Find the lowest, leftmost mouse that can move
+	bool FindStep(FBoardStep& OutStep) const;
+
+	void ApplyStep(const FBoardStep& Step);
+
+	// Take back a step applied last, putting the mouse back on From and taking back its goal if it scored
+	void UndoStep(const FBoardStep& Step);
+
+	// Resolve the whole cascade at once, returns the number of steps taken.
+	// Only columns in DirtyColumns and the columns touched by each step are re-evaluated,
+	// every other column is expected to be settled already.
+	int32 Settle(FColumnSet DirtyColumns = AllColumns);
+
+	// Same as above, appending every step in the order it happens
+	int32 Settle(TArray<FBoardStep>& OutSteps, FColumnSet DirtyColumns = AllColumns);
+
+	// Columns whose mice may start or stop moving when column X changes
+	static FColumnSet GetNeighbourColumns(int32 X);
+
+	// Bit X is set if column X holds at least one mouse of the team, kept up to date on every change
+	FORCEINLINE FColumnSet GetTeamColumns(EBoardCell Team) const { return Team == EBoardCell::Blue ? BlueColumns : RedColumns; }
+
+	// Append the index of every set bit of a column mask, lowest first
+	static void GetColumnList(FColumnSet Columns, TArray<int32>& OutColumns);
+
+	// Number of mice of the team in column X
+	FORCEINLINE int32 CountColumnMice(EBoardCell Team, int32 X) const { return FMath::CountBits(Team == EBoardCell::Blue ? BlueMice[X] : RedMice[X]); }
+
+	int32 CountMice(EBoardCell Team) const;
+
+	static bool IsGoalColumn(int32 X);
+
+	// Zobrist hash of the pieces and scores computed from scratch, Hash keeps the same value up to date incrementally
+	uint64 ComputeHash() const;
+
+	FColumn Cheese[Width];
+	FColumn BlueMice[Width];
+	FColumn RedMice[Width];
+
+	// Columns holding mice of each team. Rotating a column never changes them, only walking, scoring and SetCell do
+	FColumnSet BlueColumns;
+	FColumnSet RedColumns;
+
+	int32 BlueScore;
+	int32 RedScore;
+
+	uint64 Hash;
+
+	// Index of the lowest set bit, Bits must not be zero
+	static FORCEINLINE int32 LowestBit(uint64 Bits)
+	{
+		return uint32(Bits) != 0 ? FMath::CountTrailingZeros(uint32(Bits)) : 32 + FMath::CountTrailingZeros(uint32(Bits >> 32));
+	}
+
+private:
+	int32 SettleColumns(FColumnSet DirtyColumns, TArray<FBoardStep>* OutSteps);
+	static FColumn RotateColumn(FColumn Column, bool bUpward);
+};
+
+// The classic board, instantiated once in BoardState.cpp
+extern template struct TBoardState<19, 13, 12>;
+typedef TBoardState<19, 13, 12> FBoardState;
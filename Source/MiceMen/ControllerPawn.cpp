@@ -2,8 +2,15 @@
 
 
 #include "ControllerPawn.h"
-#include "Kismet/GameplayStatics.h"
+#include "MiceMen.h"
+#include "MoveAnalysis.h"
 #include "Engine/World.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTime.h"
+
+DECLARE_CYCLE_STAT(TEXT("Controller Tick"), STAT_ControllerTick, STATGROUP_MiceMen);
+DECLARE_CYCLE_STAT(TEXT("Update Columns"), STAT_UpdateColumns, STATGROUP_MiceMen);
+DECLARE_CYCLE_STAT(TEXT("Computer Move"), STAT_ComputerMove, STATGROUP_MiceMen);
 
 // Sets default values
 AControllerPawn::AControllerPawn()
@@ -26,8 +33,6 @@ AControllerPawn::AControllerPawn()
 	GameCamera->SetRelativeRotation(RotationOffset);
 
 	SelectedColumn = 1;
-	ErrorMargin = 0.75f;
-	InputDelay = 0.0f;
 	CurrentTeam = 1;
 	ColumnIterator = 0;
 }
@@ -38,34 +43,108 @@ void AControllerPawn::BeginPlay()
 	Super::BeginPlay();
 	PreviousColumn = 99;
 	PreviousMovedColumn = 99;
-	CurrentTeam = FMath::RandRange(1, 2);
+	CurrentTeam = int32(GameBoard->FirstTeam);
+	Replay.Reset(GameBoard->Seed, GameBoard->bFairBoard);
+	GameBoard->OnBoardSettled.AddDynamic(this, &AControllerPawn::OnBoardSettled);
+	if (bNetworkMatch)
+	{
+		StartNetworkMatch();
+	}
+}
+
+void AControllerPawn::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	CancelAnalyses();
+	NetworkSession.Reset();
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
 void AControllerPawn::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
-	if (!GameBoard->bCanSettle)
+	SCOPE_CYCLE_COUNTER(STAT_ControllerTick);
+	CSV_SCOPED_TIMING_STAT(MiceMen, ControllerTick);
+
+	UpdateNetworkMatch();
+	UpdateComputerMove();
+	UpdateHints();
+}
+
+// The grid finished playing out the last move, the next team may move right away
+void AControllerPawn::OnBoardSettled()
+{
+	if (bReady)
 	{
-		InputDelay += 1.0f * DeltaTime;
+		return;
 	}
-	else
+	bReady = true;
+	//UpdateText(GameBoard->BlueScore, GameBoard->RedScore);
+	UpdateColumns();
+	if (GameBoard->BlueScore == FBoardState::MicePerTeam - 1 && GameBoard->RedScore == FBoardState::MicePerTeam - 1)
 	{
-		InputDelay -= 1.0f * DeltaTime;
+		bDrawContdownBegan = true;
 	}
-	if (InputDelay > ErrorMargin && !bReady)
+	if (bDrawContdownBegan && TurnsBeforeDraw == 0)
 	{
-		bReady = true;
-		//UpdateText(GameBoard->BlueScore, GameBoard->RedScore);
-		UpdateColumns();
-		if (bDrawContdownBegan && TurnsBeforeDraw == 0)
+		if (bSaveReplays && !bDraw)
 		{
-			bDraw = true;
+			SaveReplay(FString());
 		}
+		bDraw = true;
+		CancelAnalyses();
 	}
-	if (GameBoard->BlueScore == 11 && GameBoard->RedScore == 11)
+
+	// Inputs pressed during the animation of a player's own move are not meant for the other side's turn
+	if (IsComputerTurn() || IsRemoteTurn() || bFinished || bDraw)
 	{
-		bDrawContdownBegan = true;
+		BufferedInputs.Reset();
+	}
+	if (IsComputerTurn())
+	{
+		StartComputerMove();
+	}
+	else
+	{
+		ApplyBufferedInputs();
+	}
+}
+
+bool AControllerPawn::BufferInput(EBufferedInput Input)
+{
+	if (bReady)
+	{
+		return false;
+	}
+	if (BufferedInputs.Num() < MaxBufferedInputs)
+	{
+		BufferedInputs.Add(Input);
+	}
+	return true;
+}
+
+void AControllerPawn::ApplyBufferedInputs()
+{
+	// Inputs after a move find the board settling again and are buffered for the turn after
+	const TArray<EBufferedInput> Inputs = MoveTemp(BufferedInputs);
+	BufferedInputs.Reset();
+	for (const EBufferedInput Input : Inputs)
+	{
+		switch (Input)
+		{
+		case EBufferedInput::Up:
+			MoveUp();
+			break;
+		case EBufferedInput::Down:
+			MoveDown();
+			break;
+		case EBufferedInput::Right:
+			MoveRight();
+			break;
+		case EBufferedInput::Left:
+			MoveLeft();
+			break;
+		}
 	}
 }
 
@@ -79,14 +158,16 @@ void AControllerPawn::SetupPlayerInputComponent(UInputComponent* PlayerInputComp
 	PlayerInputComponent->BindAction("Right", IE_Pressed, this, &AControllerPawn::MoveRight);
 	PlayerInputComponent->BindAction("Left", IE_Pressed, this, &AControllerPawn::MoveLeft);
 	PlayerInputComponent->BindAction("Reset", IE_Pressed, this, &AControllerPawn::LevelReset);
+	PlayerInputComponent->BindAction("Undo", IE_Pressed, this, &AControllerPawn::Undo);
+	PlayerInputComponent->BindAction("Redo", IE_Pressed, this, &AControllerPawn::Redo);
+	PlayerInputComponent->BindAction("Hint", IE_Pressed, this, &AControllerPawn::ShowHint);
 }
 
 void AControllerPawn::MoveUp()
 {
-	if (!bFinished && !bDraw)
+	if (!bFinished && !bDraw && !BufferInput(EBufferedInput::Up))
 	{
-		MoveSelectedColumn(true);
-		if (bDrawContdownBegan)
+		if (MoveSelectedColumn(true) && bDrawContdownBegan)
 		{
 			TurnsBeforeDraw--;
 		}
@@ -95,10 +176,9 @@ void AControllerPawn::MoveUp()
 
 void AControllerPawn::MoveDown()
 {
-	if (!bFinished && !bDraw)
+	if (!bFinished && !bDraw && !BufferInput(EBufferedInput::Down))
 	{
-		MoveSelectedColumn(false);
-		if (bDrawContdownBegan)
+		if (MoveSelectedColumn(false) && bDrawContdownBegan)
 		{
 			TurnsBeforeDraw--;
 		}
@@ -107,51 +187,45 @@ void AControllerPawn::MoveDown()
 
 void AControllerPawn::MoveRight()
 {
-	if (!bFinished && !bDraw)
+	if (!bFinished && !bDraw && !BufferInput(EBufferedInput::Right))
 	{
-		if (bReady)
+		PreviousColumn = SelectedColumn;
+		// If iterator is equal or lower than the minimum index
+		if (ColumnIterator <= 0)
 		{
-			PreviousColumn = SelectedColumn;
-			// If iterator is equal or lower than the minimum index
-			if (ColumnIterator <= 0)
-			{
-				// Wrap around to max index
-				ColumnIterator = TeamColumns.Num() - 1;
-			}
-			// Else decrement iterator
-			else
-			{
-				ColumnIterator--;
-			}
-			SelectedColumn = TeamColumns[ColumnIterator];
-			GameBoard->PaintColumn(SelectedColumn);
-			GameBoard->PaintColumn(PreviousColumn);
+			// Wrap around to max index
+			ColumnIterator = TeamColumns.Num() - 1;
 		}
+		// Else decrement iterator
+		else
+		{
+			ColumnIterator--;
+		}
+		SelectedColumn = TeamColumns[ColumnIterator];
+		GameBoard->PaintColumn(SelectedColumn);
+		GameBoard->PaintColumn(PreviousColumn);
 	}
 }
 
 void AControllerPawn::MoveLeft()
 {
-	if (!bFinished && !bDraw)
+	if (!bFinished && !bDraw && !BufferInput(EBufferedInput::Left))
 	{
-		if (bReady)
+		PreviousColumn = SelectedColumn;
+		// If iterator is equal or higher than the max index
+		if (ColumnIterator >= TeamColumns.Num() - 1)
 		{
-			PreviousColumn = SelectedColumn;
-			// If iterator is equal or higher than the max index
-			if (ColumnIterator >= TeamColumns.Num() - 1)
-			{
-				// Wrap around to minimum index
-				ColumnIterator = 0;
-			}
-			// Else increment iterator
-			else
-			{
-				ColumnIterator++;
-			}
-			SelectedColumn = TeamColumns[ColumnIterator];
-			GameBoard->PaintColumn(SelectedColumn);
-			GameBoard->PaintColumn(PreviousColumn);
+			// Wrap around to minimum index
+			ColumnIterator = 0;
 		}
+		// Else increment iterator
+		else
+		{
+			ColumnIterator++;
+		}
+		SelectedColumn = TeamColumns[ColumnIterator];
+		GameBoard->PaintColumn(SelectedColumn);
+		GameBoard->PaintColumn(PreviousColumn);
 	}
 }
 
@@ -170,6 +244,7 @@ void AControllerPawn::SwapActiveTeam()
 
 void AControllerPawn::UpdateColumns()
 {
+	SCOPE_CYCLE_COUNTER(STAT_UpdateColumns);
 	TeamColumns = GameBoard->TeamColumns(CurrentTeam);
 	ColumnIterator = 0;
 	PreviousColumn = SelectedColumn;
@@ -188,84 +263,149 @@ void AControllerPawn::UpdateColumns()
 
 void AControllerPawn::RemoveInvalidColumn()
 {
-	// If the other team has moved at least once and my mice are in more than one column
-	if (CurrentTeam == 1)
+	// Keep only the columns the match rules allow: not the other player's last column, nor one I moved on each of my last 6 turns
+	const uint32 LegalColumns = GetMatchState().GetLegalColumns();
+	for (int i = TeamColumns.Num() - 1; i >= 0; --i)
 	{
-		if (RedPreviousMoves.Num() > 0 && TeamColumns.Num() > 1)
+		if ((LegalColumns & (1u << TeamColumns[i])) == 0)
 		{
-			for (int i = 0; i < TeamColumns.Num(); ++i)
-			{
-				// If selected column was moved in the other player's last move
-				if (TeamColumns[i] == RedPreviousMoves[RedPreviousMoves.Num() - 1])
-				{
-					// Remove column from array of possible selections
-					TeamColumns.RemoveAt(i);
-				}
-				// If the selected column was moved by me on my last 6 turns
-				else if (CountEqualMoves(BluePreviousMoves, TeamColumns[i]) == 6)
-				{
-					// Remove column from array of possible selections
-					TeamColumns.RemoveAt(i);
-				}
-			}
+			// Remove column from array of possible selections
+			TeamColumns.RemoveAt(i);
 		}
 	}
-	else
+}
+
+void AControllerPawn::LevelReset()
+{
+	// The host starts every match of a network game
+	if (NetworkSession.IsValid() && !NetworkSession->IsHost())
 	{
-		if (BluePreviousMoves.Num() > 0 && TeamColumns.Num() > 1)
-		{
-			for (int i = 0; i < TeamColumns.Num(); ++i)
-			{
-				// If selected column was moved in the other player's last move
-				if (TeamColumns[i] == BluePreviousMoves[BluePreviousMoves.Num() - 1])
-				{
-					// Remove column from array of possible selections
-					TeamColumns.RemoveAt(i);
-				}
-				// If the selected column was moved by me on my last 6 turns
-				else if (CountEqualMoves(RedPreviousMoves, TeamColumns[i]) == 6)
-				{
-					// Remove column from array of possible selections
-					TeamColumns.RemoveAt(i);
-				}
-			}
-		}
+		return;
+	}
+	ResetMatch(0);
+	if (NetworkSession.IsValid())
+	{
+		NetworkSession->StartMatch(GameBoard->Seed, GameBoard->bFairBoard);
+		NetworkMatchIndex = NetworkSession->GetMatchIndex();
 	}
-	
 }
 
-void AControllerPawn::LevelReset()
+// Start a new match in the loaded level, the grid rebuilds the board from its pooled pieces
+void AControllerPawn::ResetMatch(int32 NewSeed)
 {
-	UGameplayStatics::OpenLevel(GetWorld(), FName("Level"), true);
+	CancelAnalyses();
+	BufferedInputs.Reset();
+	GameBoard->ResetBoard(NewSeed);
+
+	bReady = false;
+	bFinished = false;
+	bDraw = false;
+	bDrawContdownBegan = false;
+	TurnsBeforeDraw = FMatchState::DrawCountdownTurns;
+	BluePreviousMoves.Reset();
+	RedPreviousMoves.Reset();
+	MoveLog.Reset();
+
+	// The new pieces start without highlight, there is no previous column to paint back
+	bFirstUpdate = true;
+	PreviousColumn = 99;
+	PreviousMovedColumn = 99;
+	CurrentTeam = int32(GameBoard->FirstTeam);
+	Replay.Reset(GameBoard->Seed, GameBoard->bFairBoard);
 }
 
-void AControllerPawn::MoveSelectedColumn(bool bUpward)
+bool AControllerPawn::MoveSelectedColumn(bool bUpward)
 {
-	if (bReady)
+	if (!bReady || (!bPlayingComputerMove && IsComputerTurn()) || (!bPlayingRemoteMove && IsRemoteTurn()))
 	{
-		bReady = false;
-		InputDelay = 0.0f;
+		return false;
+	}
 
-		// Perform operations on current team's array of previous moves
-		if(CurrentTeam == 1)
+	// Local moves go to the other player first, the session checks them against the same rules
+	if (NetworkSession.IsValid() && !bPlayingRemoteMove && !NetworkSession->SubmitMove(FBoardMove(SelectedColumn, bUpward)))
+	{
+		return false;
+	}
+
+	bReady = false;
+	CancelHints();
+
+	// Log the move against the history from before it, ApplyMove adds the column itself
+	FMatchState State = GetMatchState();
+	MoveLog.Apply(State, FBoardMove(SelectedColumn, bUpward));
+
+	// Perform operations on current team's array of previous moves
+	if(CurrentTeam == 1)
+	{
+		if (BluePreviousMoves.Num() == FMatchState::MoveHistoryLength)
 		{
-			if (BluePreviousMoves.Num() == 6)
-			{
-				BluePreviousMoves.RemoveAt(0);
-			}
-			BluePreviousMoves.Add(SelectedColumn);
+			BluePreviousMoves.RemoveAt(0);
 		}
-		else
+		BluePreviousMoves.Add(SelectedColumn);
+	}
+	else
+	{
+		if (RedPreviousMoves.Num() == FMatchState::MoveHistoryLength)
 		{
-			if (RedPreviousMoves.Num() == 6)
-			{
-				RedPreviousMoves.RemoveAt(0);
-			}
-			RedPreviousMoves.Add(SelectedColumn);
+			RedPreviousMoves.RemoveAt(0);
 		}
-		GameBoard->MoveColumn(SelectedColumn, bUpward);
-		SwapActiveTeam();
+		RedPreviousMoves.Add(SelectedColumn);
+	}
+	Replay.Record(FBoardMove(SelectedColumn, bUpward));
+	GameBoard->MoveColumn(SelectedColumn, bUpward);
+	SwapActiveTeam();
+	return true;
+}
+
+void AControllerPawn::Undo()
+{
+	// Computers only ever play forward, nobody would be left on the move to play on from the earlier position
+	if (bFinished || !bReady || !GameBoard->IsSettled() || NetworkSession.IsValid() || (bBlueIsComputer && bRedIsComputer))
+	{
+		return;
+	}
+
+	// Against the computer its reply to the player's last move is taken back as well. Without a player move
+	// before it the computer would be on the move with nothing to think about, so there is nothing to undo
+	const bool bComputerOnMove = CurrentTeam == 1 ? bBlueIsComputer : bRedIsComputer;
+	const int32 NumMoves = (bBlueIsComputer || bRedIsComputer) && !bComputerOnMove ? 2 : 1;
+	if (MoveLog.Num() < NumMoves)
+	{
+		return;
+	}
+	CancelAnalyses();
+
+	FMatchState State = GetMatchState();
+	for (int32 i = 0; i < NumMoves; ++i)
+	{
+		GameBoard->UndoMove(MoveLog.GetUndoDelta(), MoveLog.GetSteps());
+		MoveLog.Undo(State);
+		Replay.Moves.Pop();
+		SetMatchState(State);
 	}
+
+	// No settle follows an undo, a computer left on the move would never be asked for one
+	checkSlow(!IsComputerTurn());
+	UpdateColumns();
+}
+
+void AControllerPawn::Redo()
+{
+	if (bFinished || bDraw || !bReady || !MoveLog.CanRedo() || NetworkSession.IsValid())
+	{
+		return;
+	}
+	bReady = false;
+	CancelAnalyses();
+
+	// The grid plays the recorded steps back, the state follows the same delta
+	FMatchState State = GetMatchState();
+	const FMoveDelta& Delta = MoveLog.GetRedoDelta();
+	Replay.Record(Delta.Move);
+	GameBoard->ReplayMove(Delta, MoveLog.GetSteps());
+	MoveLog.Redo(State);
+	SetMatchState(State);
+	UpdateColumns();
 }
 
 int32 AControllerPawn::CountEqualMoves(TArray<int32> TeamMovesArray, int32 Move)
@@ -283,7 +423,12 @@ int32 AControllerPawn::CountEqualMoves(TArray<int32> TeamMovesArray, int32 Move)
 
 void AControllerPawn::FinishMatch()
 {
+	if (bSaveReplays && !bFinished)
+	{
+		SaveReplay(FString());
+	}
 	bFinished = true;
+	CancelAnalyses();
 }
 
 bool AControllerPawn::IsFinished()
@@ -295,3 +440,337 @@ bool AControllerPawn::DidMatchDraw()
 {
 	return bDraw;
 }
+
+bool AControllerPawn::IsComputerTurn() const
+{
+	if (bFinished || bDraw || IsRemoteTurn())
+	{
+		return false;
+	}
+	return CurrentTeam == 1 ? bBlueIsComputer : bRedIsComputer;
+}
+
+bool AControllerPawn::IsRemoteTurn() const
+{
+	if (!NetworkSession.IsValid() || bFinished || bDraw)
+	{
+		return false;
+	}
+	return NetworkSession->GetStatus() != ELockstepStatus::Playing || EBoardCell(CurrentTeam) != NetworkSession->GetLocalTeam();
+}
+
+bool AControllerPawn::IsNetworkDesynced() const
+{
+	return NetworkSession.IsValid() && NetworkSession->GetStatus() == ELockstepStatus::Desynced;
+}
+
+void AControllerPawn::StartNetworkMatch()
+{
+	TUniquePtr<FSocketLockstepTransport> Transport = MakeUnique<FSocketLockstepTransport>();
+	const bool bOpened = bHostNetworkMatch ? Transport->Listen(NetworkPort) : Transport->Connect(NetworkAddress, NetworkPort);
+	if (!bOpened)
+	{
+		UE_LOG(LogMiceMen, Error, TEXT("Network match: could not open port %d"), NetworkPort);
+		return;
+	}
+
+	NetworkSession = MakeUnique<FLockstepSession>(MoveTemp(Transport), bHostNetworkMatch);
+	if (bHostNetworkMatch)
+	{
+		NetworkSession->StartMatch(GameBoard->Seed, GameBoard->bFairBoard);
+		NetworkMatchIndex = NetworkSession->GetMatchIndex();
+	}
+}
+
+// Take in what the other player sent: a new match from the host resets the board, their moves are played once it is ready
+void AControllerPawn::UpdateNetworkMatch()
+{
+	if (!NetworkSession.IsValid())
+	{
+		return;
+	}
+	NetworkSession->Update();
+
+	if (NetworkSession->GetMatchIndex() != NetworkMatchIndex)
+	{
+		NetworkMatchIndex = NetworkSession->GetMatchIndex();
+		GameBoard->bFairBoard = NetworkSession->IsFairBoard();
+		ResetMatch(NetworkSession->GetSeed());
+		return;
+	}
+
+	FBoardMove Move;
+	if (bReady && IsRemoteTurn() && NetworkSession->PopRemoteMove(Move))
+	{
+		SelectColumn(Move.Column);
+		bPlayingRemoteMove = true;
+		if (Move.bUpward)
+		{
+			MoveUp();
+		}
+		else
+		{
+			MoveDown();
+		}
+		bPlayingRemoteMove = false;
+	}
+}
+
+void AControllerPawn::CreateComputerTable()
+{
+	if (!ComputerTable.IsValid())
+	{
+		ComputerTable = MakeShared<FTranspositionTable, ESPMode::ThreadSafe>(ComputerTableSizeMB);
+	}
+}
+
+// Start thinking about the move of the current team, or keep thinking if the position was pondered
+void AControllerPawn::StartComputerMove()
+{
+	// Moves taken back are played again before thinking of new ones
+	if (MoveLog.CanRedo())
+	{
+		Redo();
+		return;
+	}
+
+	const FMatchState State = GetMatchState();
+	if (bPredictingMove || !ComputerAnalysis.IsActive() || ComputerAnalysis.GetRoot().GetHash() != State.GetHash())
+	{
+		CreateComputerTable();
+		ComputerAnalysis.Start(State, ComputerTable, bComputerAnalyzesAllMoves);
+	}
+	bPredictingMove = false;
+	ComputerMoveTime = FPlatformTime::Seconds() + ComputerThinkTime;
+}
+
+// Poll the background analysis, play its move once the think time is up and switch pondering to the reply
+void AControllerPawn::UpdateComputerMove()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ComputerMove);
+	CSV_SCOPED_TIMING_STAT(MiceMen, ComputerMove);
+
+	if (!ComputerAnalysis.IsActive())
+	{
+		return;
+	}
+	FMoveAnalysisResult Result;
+	const bool bHasResult = ComputerAnalysis.GetResult(Result) && Result.GetBestMove().IsValid();
+
+	if (bPredictingMove)
+	{
+		if (bHasResult && (ComputerAnalysis.IsComplete() || ComputerAnalysis.GetElapsedSeconds() >= PonderPredictionTime))
+		{
+			FMatchState Predicted = ComputerAnalysis.GetRoot();
+			Predicted.ApplyMove(Result.GetBestMove());
+			bPredictingMove = false;
+			if (!Predicted.IsFinished())
+			{
+				ComputerAnalysis.Start(Predicted, ComputerTable, bComputerAnalyzesAllMoves);
+			}
+			else
+			{
+				ComputerAnalysis.Cancel();
+			}
+		}
+		else if (!bHasResult && ComputerAnalysis.IsComplete())
+		{
+			CancelAnalyses();
+		}
+		return;
+	}
+
+	// Pondering the reply, nothing to play until the predicted move comes
+	if (ComputerMoveTime == 0.0)
+	{
+		return;
+	}
+
+	if (bHasResult && Result.GetBestMove().Column != SelectedColumn)
+	{
+		// Show what the computer is leaning towards while it thinks
+		SelectColumn(Result.GetBestMove().Column);
+	}
+	if (ComputerAnalysis.IsComplete() || (bHasResult && FPlatformTime::Seconds() >= ComputerMoveTime))
+	{
+		ComputerAnalysis.Cancel();
+		ComputerMoveTime = 0.0;
+		if (bHasResult)
+		{
+			PlayComputerMove(Result.GetBestMove());
+		}
+	}
+}
+
+// Play a move as if it was selected by a player, then ponder while the other team thinks
+void AControllerPawn::PlayComputerMove(FBoardMove Move)
+{
+	FMatchState After = GetMatchState();
+	After.ApplyMove(Move);
+
+	SelectColumn(Move.Column);
+	bPlayingComputerMove = true;
+	if (Move.bUpward)
+	{
+		MoveUp();
+	}
+	else
+	{
+		MoveDown();
+	}
+	bPlayingComputerMove = false;
+
+	StartPondering(After);
+}
+
+void AControllerPawn::StartPondering(const FMatchState& State)
+{
+	// Two computers think one after the other, only a player's turn leaves time to ponder
+	if (!bComputerPonders || State.IsFinished() || (bBlueIsComputer && bRedIsComputer))
+	{
+		return;
+	}
+	CreateComputerTable();
+	bPredictingMove = true;
+	ComputerAnalysis.Start(State, ComputerTable, bComputerAnalyzesAllMoves);
+}
+
+void AControllerPawn::CancelAnalyses()
+{
+	ComputerAnalysis.Cancel();
+	ComputerMoveTime = 0.0;
+	bPredictingMove = false;
+	CancelHints();
+}
+
+TArray<FMoveHint> AControllerPawn::GetMoveHints()
+{
+	TArray<FMoveHint> Hints;
+	if (bFinished || bDraw || !bReady)
+	{
+		return Hints;
+	}
+
+	const FMatchState State = GetMatchState();
+	if (HintHash != State.GetHash())
+	{
+		CancelHints();
+		CreateComputerTable();
+		HintHash = State.GetHash();
+		HintAnalysis.Start(State, ComputerTable);
+	}
+	for (const FMoveEvaluation& Evaluation : HintResult.Moves)
+	{
+		FMoveHint& Hint = Hints[Hints.AddDefaulted()];
+		Hint.Column = Evaluation.Move.Column;
+		Hint.bUpward = Evaluation.Move.bUpward;
+		Hint.Score = Evaluation.Score;
+	}
+	return Hints;
+}
+
+void AControllerPawn::ShowHint()
+{
+	if (!bReady || IsComputerTurn() || IsRemoteTurn())
+	{
+		return;
+	}
+
+	const TArray<FMoveHint> Hints = GetMoveHints();
+	if (HintAnalysis.IsActive())
+	{
+		bShowHintWhenRanked = true;
+	}
+	else if (Hints.Num() > 0)
+	{
+		SelectColumn(Hints[0].Column);
+	}
+}
+
+// Take the latest hint ranking and stop it after HintThinkTime, it may be asked for again without thinking twice
+void AControllerPawn::UpdateHints()
+{
+	if (!HintAnalysis.IsActive())
+	{
+		return;
+	}
+	HintAnalysis.GetResult(HintResult);
+	const bool bRanked = HintAnalysis.IsComplete() || (HintResult.Moves.Num() > 0 && HintAnalysis.GetElapsedSeconds() >= HintThinkTime);
+	if (!bRanked)
+	{
+		return;
+	}
+
+	HintAnalysis.Cancel();
+	if (bShowHintWhenRanked && bReady && !IsComputerTurn() && HintResult.GetBestMove().IsValid())
+	{
+		SelectColumn(HintResult.GetBestMove().Column);
+	}
+	bShowHintWhenRanked = false;
+}
+
+void AControllerPawn::CancelHints()
+{
+	HintAnalysis.Cancel();
+	HintResult = FMoveAnalysisResult();
+	HintHash = 0;
+	bShowHintWhenRanked = false;
+}
+
+void AControllerPawn::SelectColumn(int32 Column)
+{
+	PreviousColumn = SelectedColumn;
+	SelectedColumn = Column;
+	ColumnIterator = FMath::Max(TeamColumns.Find(SelectedColumn), 0);
+	GameBoard->PaintColumn(PreviousColumn);
+	GameBoard->PaintColumn(SelectedColumn);
+}
+
+FMatchState AControllerPawn::GetMatchState() const
+{
+	FMatchState State;
+	State.Board = GameBoard->Board;
+	State.SideToMove = EBoardCell(CurrentTeam);
+	State.TurnsBeforeDraw = TurnsBeforeDraw;
+	State.bDrawCountdownBegan = bDrawContdownBegan;
+
+	const TArray<int32>* TeamMoves[2] = { &BluePreviousMoves, &RedPreviousMoves };
+	for (int32 Team = 0; Team < 2; ++Team)
+	{
+		State.NumPreviousMoves[Team] = FMath::Min(TeamMoves[Team]->Num(), FMatchState::MoveHistoryLength);
+		for (int32 i = 0; i < State.NumPreviousMoves[Team]; ++i)
+		{
+			State.PreviousMoves[Team][i] = int8((*TeamMoves[Team])[TeamMoves[Team]->Num() - State.NumPreviousMoves[Team] + i]);
+		}
+	}
+	State.UpdateHash();
+	return State;
+}
+
+void AControllerPawn::SetMatchState(const FMatchState& State)
+{
+	CurrentTeam = int32(State.SideToMove);
+	TurnsBeforeDraw = State.TurnsBeforeDraw;
+	bDrawContdownBegan = State.bDrawCountdownBegan;
+	bDraw = false;
+
+	TArray<int32>* TeamMoves[2] = { &BluePreviousMoves, &RedPreviousMoves };
+	for (int32 Team = 0; Team < 2; ++Team)
+	{
+		TeamMoves[Team]->Reset();
+		for (int32 i = 0; i < State.NumPreviousMoves[Team]; ++i)
+		{
+			TeamMoves[Team]->Add(State.PreviousMoves[Team][i]);
+		}
+	}
+}
+
+bool AControllerPawn::SaveReplay(const FString& Filename)
+{
+	FString Path = Filename.IsEmpty() ? FString::Printf(TEXT("%s_%d.mmr"), *FDateTime::Now().ToString(), Replay.Seed) : Filename;
+	if (FPaths::IsRelative(Path))
+	{
+		Path = FPaths::ProjectSavedDir() / TEXT("Replays") / Path;
+	}
+	return Replay.SaveToFile(Path);
+}
@@ -7,8 +7,40 @@
 #include "Camera/CameraComponent.h"
 #include "Components/InputComponent.h"
 #include "Grid.h"
+#include "MatchState.h"
+#include "TranspositionTable.h"
+#include "MatchReplay.h"
+#include "MoveLog.h"
+#include "AsyncMoveAnalysis.h"
+#include "LockstepSession.h"
 #include "ControllerPawn.generated.h"
 
+// Player input that arrived while the board was still settling
+enum class EBufferedInput : uint8
+{
+	Up,
+	Down,
+	Right,
+	Left
+};
+
+// A legal move and how good the analysis thinks it is, for hints and move overlays
+USTRUCT(BlueprintType)
+struct FMoveHint
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Analysis")
+	int32 Column = INDEX_NONE;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Analysis")
+	bool bUpward = false;
+
+	// Higher is better for the team to move
+	UPROPERTY(BlueprintReadOnly, Category = "Analysis")
+	int32 Score = 0;
+};
+
 UCLASS()
 class MICEMEN_API AControllerPawn : public APawn
 {
@@ -26,6 +58,8 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -54,32 +88,59 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void MoveLeft();
 
+	// Take back the last move, against the computer its reply is taken back as well so it is a player's turn again.
+	// Does nothing when no player move is left to take back, or when both teams are computers
+	UFUNCTION(BlueprintCallable)
+	void Undo();
+
+	// Play the last move taken back again
+	UFUNCTION(BlueprintCallable)
+	void Redo();
+
 	UPROPERTY(VisibleAnywhere, Category = "Board Settings")
 	int32 SelectedColumn;
 	int32 PreviousColumn;
 
-	float InputDelay;
-	float ErrorMargin;
-
 	int32 PreviousMovedColumn;
 	TArray<int32> TeamColumns;
 
 	int32 CurrentTeam;
 	int32 ColumnIterator;
 
+	// The board has settled since the last move, the team to move may pick its column
 	bool bReady = false;
 
+	// Start the next turn as soon as the grid has played out the last move
+	UFUNCTION()
+	void OnBoardSettled();
+
+	// Inputs pressed while the board settles, applied in order once it is ready. A move ends the turn so
+	// whatever follows it waits for the next settle
+	TArray<EBufferedInput> BufferedInputs;
+
+	// Inputs beyond this many are dropped rather than replayed long after they were pressed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
+	int32 MaxBufferedInputs = 4;
+
+	// Queue an input for the next settle, returns false when the board is ready and the input may be applied now
+	bool BufferInput(EBufferedInput Input);
+	void ApplyBufferedInputs();
+
 	void SwapActiveTeam();
 	void UpdateColumns();
 	void RemoveInvalidColumn();
 	void LevelReset();
 
+	// Start a new match on the loaded level, a non-zero seed replaces the one the grid would pick
+	void ResetMatch(int32 NewSeed);
+
 	bool bFirstUpdate = true;
 
 	TArray<int32> BluePreviousMoves;
 	TArray<int32> RedPreviousMoves;
 
-	void MoveSelectedColumn(bool bUpward);
+	// Returns whether the move was played
+	bool MoveSelectedColumn(bool bUpward);
 
 	int32 CountEqualMoves(TArray<int32> TeamMovesArray, int32 Move);
 
@@ -91,11 +152,141 @@ public:
 
 	bool bFinished = false;
 
-	int32 TurnsBeforeDraw = 8;
+	int32 TurnsBeforeDraw = FMatchState::DrawCountdownTurns;
 	bool bDrawContdownBegan = false;
 
 	bool bDraw = false;
 
 	UFUNCTION(BlueprintCallable)
 	bool DidMatchDraw();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Computer Player")
+	bool bBlueIsComputer = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Computer Player")
+	bool bRedIsComputer = false;
+
+	// Seconds the computer may think about each move, it plays stronger the more time it has
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Computer Player")
+	float ComputerThinkTime = 1.0f;
+
+	// Memory for the positions the computer remembers between its moves
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Computer Player")
+	int32 ComputerTableSizeMB = 16;
+
+	// Score every legal move at once on the worker threads instead of running one search.
+	// Plays stronger on machines with many cores, a single search makes better use of one or two
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Computer Player")
+	bool bComputerAnalyzesAllMoves = true;
+
+	// Keep thinking while a player is on the move: first about the player's position to predict their move,
+	// then about the reply to it. When the predicted move is played that thinking carries on into the computer's turn
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Computer Player")
+	bool bComputerPonders = true;
+
+	// Seconds of pondering spent predicting the player's move before thinking about the reply
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Computer Player")
+	float PonderPredictionTime = 0.25f;
+
+	// Shared with the background analyses, which may outlive a reset
+	TSharedPtr<FTranspositionTable, ESPMode::ThreadSafe> ComputerTable;
+	void CreateComputerTable();
+
+	// The computer thinks on a background thread, the game thread only starts the analysis and polls it
+	FAsyncMoveAnalysis ComputerAnalysis;
+
+	// When the computer plays the best move found so far, zero outside of its turn
+	double ComputerMoveTime = 0.0;
+
+	// ComputerAnalysis is about a player's position, its best move is the predicted one
+	bool bPredictingMove = false;
+
+	// MoveSelectedColumn takes no player input on the computer's turn, only the move it picked
+	bool bPlayingComputerMove = false;
+
+	bool IsComputerTurn() const;
+	void StartComputerMove();
+	void UpdateComputerMove();
+	void PlayComputerMove(FBoardMove Move);
+	void StartPondering(const FMatchState& State);
+
+	// Stop thinking about moves and hints, the position they are about is no longer played
+	void CancelAnalyses();
+
+	// Seconds spent ranking the moves when a player asks for a hint
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Analysis")
+	float HintThinkTime = 0.25f;
+
+	// Every legal move of the team to move, best first, as far as they are ranked yet. Never waits: the first
+	// call for a position starts ranking it in the background and returns nothing until the first iteration is done
+	UFUNCTION(BlueprintCallable, Category = "Analysis")
+	TArray<FMoveHint> GetMoveHints();
+
+	// Select the column of the best move for the team to move, once the ranking is done
+	UFUNCTION(BlueprintCallable, Category = "Analysis")
+	void ShowHint();
+
+	FAsyncMoveAnalysis HintAnalysis;
+
+	// Latest ranking of the position with hash HintHash, zero when there is none
+	FMoveAnalysisResult HintResult;
+	uint64 HintHash = 0;
+	bool bShowHintWhenRanked = false;
+
+	void UpdateHints();
+	void CancelHints();
+
+	// Move the selection to a column, repainting the old and new column
+	void SelectColumn(int32 Column);
+
+	// Snapshot of the match for the headless rules
+	FMatchState GetMatchState() const;
+
+	// Take the turn, move history and draw countdown from a match state, the board is left to GameBoard
+	void SetMatchState(const FMatchState& State);
+
+	// Play against another machine in lockstep: each side runs the rules itself and only the seed and the moves are exchanged
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	bool bNetworkMatch = false;
+
+	// Listen for the other player and pick the boards, the host plays blue. Otherwise join the host at NetworkAddress
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	bool bHostNetworkMatch = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	FString NetworkAddress = TEXT("127.0.0.1");
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	int32 NetworkPort = 7777;
+
+	TUniquePtr<FLockstepSession> NetworkSession;
+
+	// Match of NetworkSession the board was last reset to
+	int32 NetworkMatchIndex = 0;
+
+	// MoveSelectedColumn is playing the other player's move, it is not sent back
+	bool bPlayingRemoteMove = false;
+
+	// The team to move is played on the other machine, or the host has not started the match yet
+	bool IsRemoteTurn() const;
+	void StartNetworkMatch();
+	void UpdateNetworkMatch();
+
+	// The other machine played a move that does not fit this match, nothing more is played until the host starts a new one
+	UFUNCTION(BlueprintCallable, Category = "Network")
+	bool IsNetworkDesynced() const;
+
+	// Every move of the match, for undo and redo
+	FMoveLog MoveLog;
+
+	// Seed of the board and every move played so far
+	FMatchReplay Replay;
+
+	// Write the replay of this match, relative filenames go to Saved/Replays and an empty one is named after the time and seed
+	UFUNCTION(BlueprintCallable, Category = "Replay")
+	bool SaveReplay(const FString& Filename);
+
+	// Save a replay named after the seed and time whenever a match ends
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replay")
+	bool bSaveReplays = false;
 };
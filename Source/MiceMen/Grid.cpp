@@ -2,9 +2,29 @@
 
 
 #include "Grid.h"
+#include "MiceMen.h"
 #include "Block.h"
+#include "BoardGenerator.h"
 #include "Engine/World.h"
 #include "Components/TextRenderComponent.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "UObject/ConstructorHelpers.h"
+#include "Materials/MaterialInstance.h"
+
+DECLARE_CYCLE_STAT(TEXT("Grid Tick"), STAT_GridTick, STATGROUP_MiceMen);
+DECLARE_CYCLE_STAT(TEXT("Settle Playback"), STAT_SettlePlayback, STATGROUP_MiceMen);
+DECLARE_CYCLE_STAT(TEXT("Animate Pieces"), STAT_AnimatePieces, STATGROUP_MiceMen);
+DECLARE_CYCLE_STAT(TEXT("Flush Instances"), STAT_FlushInstances, STATGROUP_MiceMen);
+DECLARE_CYCLE_STAT(TEXT("Move Column"), STAT_GridMoveColumn, STATGROUP_MiceMen);
+DECLARE_CYCLE_STAT(TEXT("Board Settle"), STAT_BoardSettle, STATGROUP_MiceMen);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Settle Steps Resolved"), STAT_SettleStepsResolved, STATGROUP_MiceMen);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Settle Steps Played"), STAT_SettleStepsPlayed, STATGROUP_MiceMen);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Settle Steps Waiting"), STAT_SettleStepsWaiting, STATGROUP_MiceMen);
+DECLARE_CYCLE_STAT(TEXT("Reset Board"), STAT_ResetBoard, STATGROUP_MiceMen);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cell Lookups"), STAT_CellLookups, STATGROUP_MiceMen);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Active Tweens"), STAT_ActiveTweens, STATGROUP_MiceMen);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Column Moves"), STAT_ColumnMoves, STATGROUP_MiceMen);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Goals Scored"), STAT_GoalsScored, STATGROUP_MiceMen);
 
 // Sets default values
 AGrid::AGrid()
@@ -12,305 +32,627 @@ AGrid::AGrid()
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 	IterationOffset = 100.0f;
+
+	//Structure to hold one-time initialization
+	struct FConstructorStatics
+	{
+		ConstructorHelpers::FObjectFinderOptional<UMaterial> BaseMaterial;
+		ConstructorHelpers::FObjectFinderOptional<UMaterialInstance> BlueMaterial;
+		ConstructorHelpers::FObjectFinderOptional<UMaterialInstance> RedMaterial;
+		ConstructorHelpers::FObjectFinderOptional<UMaterialInstance> HighlightMaterial;
+		FConstructorStatics()
+			: BaseMaterial(TEXT("/Game/Materials/BaseMaterial.BaseMaterial"))
+			, BlueMaterial(TEXT("/Game/Materials/BlueMaterialInstance.BlueMaterialInstance"))
+			, RedMaterial(TEXT("/Game/Materials/RedMaterialInstance.RedMaterialInstance"))
+			, HighlightMaterial(TEXT("/Game/Materials/HighlightedMaterialInstance.HighlightedMaterialInstance"))
+		{
+		}
+
+	};
+	static FConstructorStatics ConstructorStatics;
+
+	// Create dummy root scene component
+	DummyRoot = CreateDefaultSubobject<USceneComponent>(TEXT("Dummy0"));
+	RootComponent = DummyRoot;
+
+	// Create one instanced mesh per piece type, they stay empty unless instanced rendering is enabled
+	CheeseInstances = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("CheeseInstances"));
+	HighlightInstances = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("HighlightInstances"));
+	BlueInstances = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("BlueInstances"));
+	RedInstances = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("RedInstances"));
+	for (UHierarchicalInstancedStaticMeshComponent* Instances : { CheeseInstances, HighlightInstances, BlueInstances, RedInstances })
+	{
+		Instances->SetupAttachment(RootComponent);
+		Instances->SetMobility(EComponentMobility::Movable);
+		Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	}
+
+	// Save pointers to the materials
+	BaseMaterial = ConstructorStatics.BaseMaterial.Get();
+	BlueMaterial = ConstructorStatics.BlueMaterial.Get();
+	RedMaterial = ConstructorStatics.RedMaterial.Get();
+	HighlightMaterial = ConstructorStatics.HighlightMaterial.Get();
+}
+
+// Pick the seed before any BeginPlay so the controller can read the first team from it
+void AGrid::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	bPickNewSeed = Seed == 0;
+	PickSeed();
+}
+
+// Draw the seed of the match, when the board is not generated up front only the first team is drawn here
+void AGrid::PickSeed()
+{
+	if (bPickNewSeed)
+	{
+		RandomStream.GenerateNewSeed();
+		Seed = RandomStream.GetInitialSeed();
+	}
+	RandomStream.Initialize(Seed);
+	if (bFairBoard)
+	{
+		FMatchState Match;
+		FBoardGenerator().Generate(Seed, Match);
+		Board = Match.Board;
+		FirstTeam = Match.SideToMove;
+	}
+	else
+	{
+		FirstTeam = EBoardCell(RandomStream.RandRange(1, 2));
+	}
 }
 
 // Called when the game starts or when spawned
 void AGrid::BeginPlay()
 {
 	Super::BeginPlay();
-	GridInitialization();
-	Populate();
+
+	if (bUseInstancedRendering)
+	{
+		CheeseInstances->SetStaticMesh(CheeseMesh);
+		CheeseInstances->SetMaterial(0, BaseMaterial);
+		HighlightInstances->SetStaticMesh(CheeseMesh);
+		HighlightInstances->SetMaterial(0, HighlightMaterial);
+		BlueInstances->SetStaticMesh(MiceMesh);
+		BlueInstances->SetMaterial(0, BlueMaterial);
+		RedInstances->SetStaticMesh(MiceMesh);
+		RedInstances->SetMaterial(0, RedMaterial);
+	}
+
+	BuildBoard();
+}
+
+// Create the pieces of the board drawn by PickSeed
+void AGrid::BuildBoard()
+{
+	if (bFairBoard)
+	{
+		// Board was generated and settled up front, only the pieces are missing
+		Cells.Init(INDEX_NONE, FBoardState::Width * FBoardState::Height);
+		AddPiecesOfType(EBoardCell::Cheese);
+		AddPiecesOfType(EBoardCell::Red);
+		AddPiecesOfType(EBoardCell::Blue);
+		BlueScore = Board.BlueScore;
+		RedScore = Board.RedScore;
+	}
+	else
+	{
+		GridInitialization();
+		Populate();
+		Board.Settle(PendingSteps);
+	}
+	if (bTurbo)
+	{
+		FinishSettle();
+	}
+}
+
+void AGrid::ResetBoard(int32 NewSeed)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ResetBoard);
+	ReleasePieces();
+	Board.Reset();
+	BlueScore = 0;
+	RedScore = 0;
+	if (NewSeed != 0)
+	{
+		Seed = NewSeed;
+		bPickNewSeed = false;
+	}
+	PickSeed();
+	BuildBoard();
+	FlushInstances();
+	SetActorTickEnabled(true);
+	OnBoardReset.Broadcast();
+}
+
+// Give every piece back to the pools, including mice that already scored
+void AGrid::ReleasePieces()
+{
+	ActiveTweens.Reset();
+	PendingSteps.Reset();
+	for (FGridPiece& Piece : Pieces)
+	{
+		if (Piece.Actor != nullptr)
+		{
+			Piece.Actor->SetActorHiddenInGame(true);
+			BlockPool.Add(Piece.Actor);
+		}
+		else
+		{
+			// Hidden like the highlight twins, by scaling to zero
+			const FTransform Hidden(FRotator::ZeroRotator, Piece.Location, FVector::ZeroVector);
+			GetInstances(Piece.Type)->UpdateInstanceTransform(Piece.InstanceIndex, Hidden, true, false, true);
+			if (Piece.Type == EType::Block)
+			{
+				HighlightInstances->UpdateInstanceTransform(Piece.InstanceIndex, Hidden, true, false, true);
+			}
+			FreeInstances[int32(Piece.Type)].Add(Piece.InstanceIndex);
+			bInstancesDirty = true;
+		}
+	}
+	Pieces.Reset();
+	ScoredPieces.Reset();
 }
 
 // Called every frame
 void AGrid::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
-
-	CheckGoal(-1);
-	CheckGoal(19);
+	SCOPE_CYCLE_COUNTER(STAT_GridTick);
+	CSV_SCOPED_TIMING_STAT(MiceMen, GridTick);
 
 	bCanSettle = SettleBoard();
+	AnimatePieces(DeltaTime * AnimationTimeScale);
+	FlushInstances();
+
+	SET_DWORD_STAT(STAT_SettleStepsWaiting, PendingSteps.Num());
+	SET_DWORD_STAT(STAT_ActiveTweens, ActiveTweens.Num());
+	CSV_CUSTOM_STAT(MiceMen, SettleStepsWaiting, PendingSteps.Num(), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(MiceMen, ActiveTweens, ActiveTweens.Num(), ECsvCustomStatOp::Set);
+
+	// Nothing left to animate, stop ticking until the next column move
+	if (!bCanSettle && ActiveTweens.Num() == 0)
+	{
+		SetActorTickEnabled(false);
+		OnBoardSettled.Broadcast();
+	}
 }
 
 // Initialize the grid coordinates and randomly place cheese blocks
 void AGrid::GridInitialization()
 {
-	for (int32 x = 0; x < 19; ++x)
+	Cells.Init(INDEX_NONE, FBoardState::Width * FBoardState::Height);
+	Board.GenerateCheese(RandomStream);
+	AddPiecesOfType(EBoardCell::Cheese);
+}
+
+// Populate the grid with mice of both teams
+void AGrid::Populate()
+{
+	Board.GenerateMice(RandomStream);
+	AddPiecesOfType(EBoardCell::Red);
+	AddPiecesOfType(EBoardCell::Blue);
+}
+
+// Create the pieces for every cell of the board holding the given type
+void AGrid::AddPiecesOfType(EBoardCell Type)
+{
+	for (int32 x = 0; x < FBoardState::Width; ++x)
 	{
-		for (int32 y = 0; y < 13; ++y)
+		for (int32 y = 0; y < FBoardState::Height; ++y)
 		{
-			FIntPoint NewPoint(x, y);
-
-			if (x == 0 || x == 18)
+			if (Board.GetCell(x, y) == Type)
 			{
-				if (y % 3 == 0)
-				{
-					AddBlock(NewPoint, 0);
-				}
-				else
-				{
-					BlockMap.Add(NewPoint);
-				}
-			}
-			else if (FMath::RandRange(0, 1) == 0)
-			{
-				BlockMap.Add(NewPoint);
-			}
-			else
-			{
-				AddBlock(NewPoint, 0);
+				const FIntPoint Coordinates(x, y);
+				Cells[CellIndex(Coordinates)] = AddPiece(Coordinates, EType(Type));
 			}
 		}
 	}
 }
 
-// Populate the grid with mice of both teams
-void AGrid::Populate()
+// Add a single block to the grid with a specific coordinate and type as inputs
+void AGrid::AddBlock(FIntPoint Coordinates, int32 type)
 {
-	int NumberOfMice = 12;
-	int TeamsToPopulate = 2;
-	while (NumberOfMice > 0 && TeamsToPopulate == 2)
+	Cells[CellIndex(Coordinates)] = AddPiece(Coordinates, EType(type));
+	Board.SetCell(Coordinates.X, Coordinates.Y, EBoardCell(type));
+}
+
+// Create the piece drawing a block, either an instance or a block actor, and return its index
+int32 AGrid::AddPiece(FIntPoint Coordinates, EType Type)
+{
+	FGridPiece NewPiece;
+	NewPiece.Type = Type;
+	NewPiece.Coordinates = Coordinates;
+	NewPiece.Location = FVector(Coordinates.X * IterationOffset, 0.0f, Coordinates.Y * IterationOffset);
+
+	if (bUseInstancedRendering)
 	{
-		FIntPoint NewPoint(FMath::RandRange(0, 8), FMath::RandRange(0, 12));
-		if (BlockMap[NewPoint] == nullptr)
+		TArray<int32>& TypeFreeInstances = FreeInstances[int32(Type)];
+		if (TypeFreeInstances.Num() > 0)
 		{
-			AddBlock(NewPoint, 2);
-			--NumberOfMice;
+			// Reuse an instance of a previous match, its twin is still hidden
+			NewPiece.InstanceIndex = TypeFreeInstances.Pop(false);
+			GetInstances(Type)->UpdateInstanceTransform(NewPiece.InstanceIndex, FTransform(NewPiece.Location), true, false, true);
+			bInstancesDirty = true;
+		}
+		else
+		{
+			NewPiece.InstanceIndex = GetInstances(Type)->AddInstanceWorldSpace(FTransform(NewPiece.Location));
+			if (Type == EType::Block)
+			{
+				// The highlighted twin starts hidden, instances are scaled to zero instead of removed so indices stay stable
+				HighlightInstances->AddInstanceWorldSpace(FTransform(FRotator::ZeroRotator, NewPiece.Location, FVector::ZeroVector));
+			}
 		}
 	}
-	--TeamsToPopulate;
-	NumberOfMice = 12;
-	while (NumberOfMice > 0 && TeamsToPopulate == 1)
+	else
 	{
-		FIntPoint NewPoint(FMath::RandRange(10, 18), FMath::RandRange(0, 12));
-		if (BlockMap[NewPoint] == nullptr)
+		ABlock* NewBlock = nullptr;
+		if (BlockPool.Num() > 0)
+		{
+			NewBlock = BlockPool.Pop(false);
+			NewBlock->SetActorLocation(NewPiece.Location);
+			NewBlock->SetActorHiddenInGame(false);
+		}
+		else
+		{
+			NewBlock = GetWorld()->SpawnActor<ABlock>(NewPiece.Location, FRotator(0, 0, 0));
+		}
+		NewBlock->SetType(Type);
+		NewBlock->SetCoordinates(Coordinates);
+		NewBlock->GameBoard = this;
+
+		if (Type == EType::Block)
 		{
-			AddBlock(NewPoint, 1);
-			--NumberOfMice;
+			NewBlock->SetMesh(CheeseMesh);
 		}
+		else
+		{
+			NewBlock->SetMesh(MiceMesh);
+		}
+		NewPiece.Actor = NewBlock;
 	}
+
+	return Pieces.Add(NewPiece);
 }
 
-// Add a single block to the grid with a specific coordinate and type as inputs
-void AGrid::AddBlock(FIntPoint Coordinates, int32 type)
+// Shift all blocks of a column upward or downward by 1 unit
+void AGrid::MoveColumn(int32 HorizontalCoordinate, bool Upward)
 {
-	ABlock* NewBlock = GetWorld()->SpawnActor<ABlock>(FVector(Coordinates.X * IterationOffset, 0.0f, Coordinates.Y * IterationOffset), FRotator(0, 0, 0));
-	NewBlock->SetType(EType(type));
-	NewBlock->SetCoordinates(Coordinates);
-	NewBlock->GameBoard = this;
-	BlockMap.Add(Coordinates, NewBlock);
+	SCOPE_CYCLE_COUNTER(STAT_GridMoveColumn);
+	INC_DWORD_STAT(STAT_ColumnMoves);
+	CSV_CUSTOM_STAT(MiceMen, ColumnMoves, 1, ECsvCustomStatOp::Accumulate);
+
+	MoveColumnPieces(HorizontalCoordinate, Upward);
 
-	if (type == 0)
+	// Only the moved column and its neighbours can have mice that start moving
+	Board.MoveColumn(HorizontalCoordinate, Upward);
 	{
-		NewBlock->SetMesh(CheeseMesh);
+		SCOPE_CYCLE_COUNTER(STAT_BoardSettle);
+		const int32 NumSteps = Board.Settle(PendingSteps, FBoardState::GetNeighbourColumns(HorizontalCoordinate));
+		INC_DWORD_STAT_BY(STAT_SettleStepsResolved, NumSteps);
+		CSV_CUSTOM_STAT(MiceMen, SettleStepsResolved, NumSteps, ECsvCustomStatOp::Accumulate);
 	}
-	else
+	if (bTurbo)
 	{
-		NewBlock->SetMesh(MiceMesh);
+		FinishSettle();
 	}
+	SetActorTickEnabled(true);
 }
 
-// Shift all blocks of a column upward or downward by 1 unit
-void AGrid::MoveColumn(int32 HorizontalCoordinate, bool Upward)
+// Same as MoveColumn, the settle steps recorded the first time the move was played are reused instead of settling again
+void AGrid::ReplayMove(const FMoveDelta& Delta, const TArray<FBoardStep>& Steps)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GridMoveColumn);
+	INC_DWORD_STAT(STAT_ColumnMoves);
+	CSV_CUSTOM_STAT(MiceMen, ColumnMoves, 1, ECsvCustomStatOp::Accumulate);
+
+	MoveColumnPieces(Delta.Move.Column, Delta.Move.bUpward);
+
+	Board.MoveColumn(Delta.Move.Column, Delta.Move.bUpward);
+	for (int32 i = Delta.FirstStep; i < Delta.FirstStep + Delta.NumSteps; ++i)
+	{
+		Board.ApplyStep(Steps[i]);
+		PendingSteps.Add(Steps[i]);
+	}
+	if (bTurbo)
+	{
+		FinishSettle();
+	}
+	SetActorTickEnabled(true);
+}
+
+void AGrid::UndoMove(const FMoveDelta& Delta, const TArray<FBoardStep>& Steps)
 {
-	//Create New TMap with items moved 1 unit above or below, append to original TMap to replace items
-	TMap<FIntPoint, AActor*> NewGrid;
-	for (int32 y = 0; y < 13; ++y)
+	check(IsSettled());
+	SCOPE_CYCLE_COUNTER(STAT_GridMoveColumn);
+	FinishTweens();
+
+	// Walk the steps backwards, each mouse jumps from where the step took it back to where it came from
+	for (int32 i = Delta.FirstStep + Delta.NumSteps - 1; i >= Delta.FirstStep; --i)
 	{
-		FIntPoint PointToMove = FIntPoint(HorizontalCoordinate, y); //Point of current iteration on a given horizontal coordinate
-		if (BlockMap.Contains(PointToMove))
+		const FBoardStep& Step = Steps[i];
+		int32 Piece = INDEX_NONE;
+		if (FBoardState::IsGoalColumn(Step.To.X))
 		{
-			ABlock* Item = Cast<ABlock>(BlockMap[PointToMove]);	//Item associated to point in grid
-			FIntPoint MovedPoint;
-			if (Upward)
+			// The latest mouse that scored through this cell, steps through the same cell are always played in order
+			for (int32 j = ScoredPieces.Num() - 1; j >= 0 && Piece == INDEX_NONE; --j)
 			{
-				if (y < 12)
-				{
-					MovedPoint = FIntPoint(HorizontalCoordinate, y + 1); //Move blocks upward
-					if (Item != nullptr)
-					{
-						Item->MoveTo(Item->GetActorLocation() + FVector(0.0f, 0.0f, +IterationOffset), 1);
-					}
-
-				}
-				else
+				if (Pieces[ScoredPieces[j]].Coordinates == Step.To)
 				{
-					MovedPoint = FIntPoint(HorizontalCoordinate, 0);
-					if (Item != nullptr)
-					{
-						FVector CurrentLocation = Item->GetActorLocation();
-						Item->SetActorLocation(CurrentLocation + FVector(0.0f, 100.0f, 0.0f));
-						Item->MoveTo(CurrentLocation + FVector(0.0f, 100.0f, -CurrentLocation.Z), 2);
-					}
+					Piece = ScoredPieces[j];
+					ScoredPieces.RemoveAt(j);
 				}
 			}
-			else
-			{
-				if (y != 0)
-				{
-					MovedPoint = FIntPoint(HorizontalCoordinate, y - 1);
-					if (Item != nullptr)
-					{
-						Item->MoveTo(Item->GetActorLocation() + FVector(0.0f, 0.0f, -IterationOffset), 1);
-					}
-				}
-				else
-				{
-					MovedPoint = FIntPoint(HorizontalCoordinate, 12);
-					if (Item != nullptr)
-					{
-						FVector CurrentLocation = Item->GetActorLocation();
-						Item->SetActorLocation(CurrentLocation + FVector(0.0f, 100.0f, 0.0f));
-						Item->MoveTo(CurrentLocation + FVector(0.0f, 100.0f, IterationOffset * 12.0f), 2);
-					}
+			check(Piece != INDEX_NONE);
 
-				}
-			}
-			if (Item != nullptr)
-			{
-				NewGrid.Add(MovedPoint, Item);
-				Item->SetCoordinates(MovedPoint);
-			}
+			const bool bIsBlue = Pieces[Piece].Type == EType::Blue;
+			(bIsBlue ? BlueScore : RedScore)--;
+			OnGoalUndone.Broadcast(bIsBlue, BlueScore, RedScore);
 		}
+		else
+		{
+			Piece = Cells[CellIndex(Step.To)];
+			Cells[CellIndex(Step.To)] = INDEX_NONE;
+		}
+
+		Cells[CellIndex(Step.From)] = Piece;
+		SetPieceCoordinates(Piece, Step.From);
+		SetPieceLocation(Piece, FVector(Step.From.X * IterationOffset, 0.0f, Step.From.Y * IterationOffset));
+		Board.UndoStep(Step);
+	}
 
+	// Rotate the column back the other way
+	const int32 Column = Delta.Move.Column;
+	RotateColumnCells(Column, !Delta.Move.bUpward);
+	for (int32 y = 0; y < FBoardState::Height; ++y)
+	{
+		const int32 Piece = Cells[CellIndex(Column, y)];
+		if (Piece != INDEX_NONE)
+		{
+			SetPieceCoordinates(Piece, FIntPoint(Column, y));
+			SetPieceLocation(Piece, FVector(Column * IterationOffset, 0.0f, y * IterationOffset));
+		}
 	}
+	Board.MoveColumn(Column, !Delta.Move.bUpward);
+	FlushInstances();
+}
+
+bool AGrid::IsSettled() const
+{
+	return PendingSteps.Num() == 0;
+}
 
-	for (int32 j = 0; j < 13; ++j)
+void AGrid::FinishTweens()
+{
+	for (int32 i = ActiveTweens.Num() - 1; i >= 0; --i)
 	{
-		FIntPoint CurrentPoint = FIntPoint(HorizontalCoordinate, j);
-		BlockMap.Remove(CurrentPoint);
+		const FPieceTween& Tween = ActiveTweens[i];
+		ApplyPieceLocation(Tween.Piece, Tween.bHasNextStage ? Tween.NextTargetLocation : Tween.TargetLocation);
+		RemoveTween(i);
 	}
+}
 
-	BlockMap.Append(NewGrid);
+void AGrid::FinishSettle()
+{
+	// Each pass plays at least the first pending step, once the pieces before it have finished moving
+	do
+	{
+		FinishTweens();
+	}
+	while (SettleBoard());
+	FinishTweens();
+	FlushInstances();
+	checkSlow(MatchesBoard());
 }
 
-// Toggle highlight on cheese blocks of a specific column
-void AGrid::PaintColumn(int32 column)
+bool AGrid::MatchesBoard() const
 {
-	for (int32 y = 0; y < 13; ++y)
+	if (!IsSettled() || BlueScore != Board.BlueScore || RedScore != Board.RedScore)
+	{
+		return false;
+	}
+	for (int32 x = 0; x < FBoardState::Width; ++x)
 	{
-		FIntPoint NewPoint(column, y);
-		if (BlockMap.Contains(NewPoint))
+		for (int32 y = 0; y < FBoardState::Height; ++y)
 		{
-			ABlock* PaintedObject = Cast<ABlock>(BlockMap[NewPoint]);
-			if (PaintedObject != nullptr)
+			const int32 Piece = Cells[CellIndex(x, y)];
+			const EBoardCell Cell = Board.GetCell(x, y);
+			if (Piece == INDEX_NONE ? Cell != EBoardCell::Empty : (Pieces[Piece].Type != EType(Cell) || Pieces[Piece].Coordinates != FIntPoint(x, y)))
 			{
-				PaintedObject->HighlightToggle();
+				return false;
 			}
 		}
 	}
+	return true;
 }
 
-// Look for mice that can move
-bool AGrid::SettleBoard()
+void AGrid::SetTurbo(bool bInTurbo)
+{
+	bTurbo = bInTurbo;
+	if (bTurbo && HasActorBegunPlay())
+	{
+		FinishSettle();
+	}
+}
+
+void AGrid::MoveColumnPieces(int32 HorizontalCoordinate, bool Upward)
 {
-	for (int32 y = 0; y < 13; ++y)
+	const int32 LastRow = FBoardState::Height - 1;
+	for (int32 y = 0; y < FBoardState::Height; ++y)
 	{
-		for (int32 x = 0; x < 19; ++x)
+		int32 Item = Cells[CellIndex(HorizontalCoordinate, y)]; //Item at point of current iteration on a given horizontal coordinate
+		if (Item == INDEX_NONE)
+		{
+			continue;
+		}
+
+		FVector CurrentLocation = GetPieceLocation(Item);
+		if (Upward)
 		{
-			FIntPoint NewPoint(x, y);
-			if (BlockMap.Contains(NewPoint))
+			if (y < LastRow)
 			{
-				ABlock* BoardPiece = Cast<ABlock>(BlockMap[NewPoint]);
-				if (BoardPiece != nullptr)
-				{
-					// If actor is not a static block
-					if (BoardPiece->ActorType != EType::Block)
-					{
-						BoardPiece->UpdateNeighbours();
-						if (BoardPiece->IsFalling())
-						{
-							FVector Destination = BoardPiece->GetActorLocation() + FVector(0.0f, 0.0f, IterationOffset * -1);
-							FIntPoint MovedPoint = FIntPoint(NewPoint.X, NewPoint.Y - 1);
-							BlockMap.Add(MovedPoint, BoardPiece);
-							BoardPiece->MoveTo(Destination, 1);
-							BoardPiece->SetCoordinates(MovedPoint);
-							BlockMap.Remove(NewPoint);
-							return true;
-						}
-						else if (BoardPiece->CanWalk())
-						{
-							FIntPoint MovedPoint;
-							FVector Destination;
-							if (BoardPiece->ActorType == EType::Blue)
-							{
-								Destination = BoardPiece->GetActorLocation() + FVector(IterationOffset * -1, 0.0f, 0.0f);
-								MovedPoint = FIntPoint(NewPoint.X - 1, NewPoint.Y);
-							}
-							else
-							{
-								Destination = BoardPiece->GetActorLocation() + FVector(IterationOffset, 0.0f, 0.0f);
-								MovedPoint = FIntPoint(NewPoint.X + 1, NewPoint.Y);
-							}
-							BlockMap.Add(MovedPoint, BoardPiece);
-							BoardPiece->MoveTo(Destination, 1);
-							BoardPiece->SetCoordinates(MovedPoint);
-							BlockMap.Remove(NewPoint);
-							return true;
-						}
-					}
-				}
+				MovePiece(Item, CurrentLocation + FVector(0.0f, 0.0f, +IterationOffset), 1); //Move blocks upward
+			}
+			else
+			{
+				// Wrap around behind the board, then come back to the front at the bottom
+				SetPieceLocation(Item, CurrentLocation + FVector(0.0f, 100.0f, 0.0f));
+				MovePiece(Item, CurrentLocation + FVector(0.0f, 100.0f, -CurrentLocation.Z), 2);
+				QueuePieceMove(Item, FVector(CurrentLocation.X, 0.0f, 0.0f), 1);
 			}
+			SetPieceCoordinates(Item, FIntPoint(HorizontalCoordinate, y < LastRow ? y + 1 : 0));
+		}
+		else
+		{
+			if (y != 0)
+			{
+				MovePiece(Item, CurrentLocation + FVector(0.0f, 0.0f, -IterationOffset), 1);
+			}
+			else
+			{
+				SetPieceLocation(Item, CurrentLocation + FVector(0.0f, 100.0f, 0.0f));
+				MovePiece(Item, CurrentLocation + FVector(0.0f, 100.0f, IterationOffset * LastRow), 2);
+				QueuePieceMove(Item, FVector(CurrentLocation.X, 0.0f, IterationOffset * LastRow), 1);
+			}
+			SetPieceCoordinates(Item, FIntPoint(HorizontalCoordinate, y != 0 ? y - 1 : LastRow));
 		}
 	}
-	// If the foor loop is completed without detecting a mice than should move, return false (nullptr)
-	return false;
+
+	RotateColumnCells(HorizontalCoordinate, Upward);
 }
 
-// Create and return an array with the coordinates of columns that contain members of a specific team
-TArray<int32> AGrid::TeamColumns(int32 Team)
+//Rotate the column slice of the grid in place, the column is strided by the row length
+void AGrid::RotateColumnCells(int32 HorizontalCoordinate, bool Upward)
 {
-	TArray<int32> TeamColumnArray;
+	const int32 LastRow = FBoardState::Height - 1;
+	if (Upward)
+	{
+		int32 Wrapped = Cells[CellIndex(HorizontalCoordinate, LastRow)];
+		for (int32 y = LastRow; y > 0; --y)
+		{
+			Cells[CellIndex(HorizontalCoordinate, y)] = Cells[CellIndex(HorizontalCoordinate, y - 1)];
+		}
+		Cells[CellIndex(HorizontalCoordinate, 0)] = Wrapped;
+	}
+	else
+	{
+		int32 Wrapped = Cells[CellIndex(HorizontalCoordinate, 0)];
+		for (int32 y = 0; y < LastRow; ++y)
+		{
+			Cells[CellIndex(HorizontalCoordinate, y)] = Cells[CellIndex(HorizontalCoordinate, y + 1)];
+		}
+		Cells[CellIndex(HorizontalCoordinate, LastRow)] = Wrapped;
+	}
+}
 
-	for (int x = 0; x < 19; ++x)
+// Toggle highlight on cheese blocks of a specific column
+void AGrid::PaintColumn(int32 column)
+{
+	for (int32 y = 0; y < FBoardState::Height; ++y)
 	{
-		for (int y = 0; y < 13; ++y)
+		int32 PaintedObject = Cells[CellIndex(column, y)];
+		if (PaintedObject != INDEX_NONE)
 		{
-			FIntPoint NewPoint = FIntPoint(x, y);
-			if (BlockMap.Contains(NewPoint))
-			{
-				ABlock* BoardPiece = Cast<ABlock>(BlockMap[NewPoint]);
-				if (BoardPiece != nullptr)
-				{
-					// If actor is not a static block
-					if (BoardPiece->ActorType == EType(Team))
-					{
-						TeamColumnArray.Add(x);
-						break;
-					}
-				}
-			}
+			TogglePieceHighlight(PaintedObject);
 		}
 	}
-	return TeamColumnArray;
+	FlushInstances();
 }
 
-// Check if any mice has reached the goal (change this to prevent performance bottleneck)
-void AGrid::CheckGoal(int32 GoalPosition)
+// Animate pending settle steps, returns true while there are steps left to play
+bool AGrid::SettleBoard()
 {
-	for (int y = 0; y < 13; ++y)
+	SCOPE_CYCLE_COUNTER(STAT_SettlePlayback);
+
+	// Cells touched by steps left waiting this frame, one mask per column including both goals. A step has to wait
+	// for any earlier waiting step that touches the same cells, this also keeps the steps of a single mouse in order
+	FBoardState::FColumn BusyCells[FBoardState::Width + 2] = {};
+	auto CellBit = [](FIntPoint Cell) { return FBoardState::FColumn(1u << Cell.Y); };
+	auto IsBusy = [&BusyCells, &CellBit](FIntPoint Cell) { return (BusyCells[Cell.X + 1] & CellBit(Cell)) != 0; };
+
+	// Waiting steps are moved down over the played ones, keeping their order
+	int32 NumWaiting = 0;
+	for (int32 i = 0; i < PendingSteps.Num(); ++i)
 	{
-		ABlock* Mice;
-		FIntPoint GoalPoint = FIntPoint(GoalPosition, y);
-		if (BlockMap.Contains(GoalPoint))
+		const FBoardStep Step = PendingSteps[i];
+		bool bWait = IsBusy(Step.From) || IsBusy(Step.To);
+
+		int32 BoardPiece = INDEX_NONE;
+		if (!bWait)
+		{
+			INC_DWORD_STAT(STAT_CellLookups);
+			BoardPiece = Cells[CellIndex(Step.From)];
+
+			// Mice that are still playing their last movement wait for the next frame
+			bWait = BoardPiece != INDEX_NONE && IsPieceMoving(BoardPiece);
+		}
+		if (bWait)
+		{
+			BusyCells[Step.From.X + 1] |= CellBit(Step.From);
+			BusyCells[Step.To.X + 1] |= CellBit(Step.To);
+			PendingSteps[NumWaiting++] = Step;
+			continue;
+		}
+
+		if (BoardPiece != INDEX_NONE)
 		{
-			Mice = Cast<ABlock>(BlockMap[GoalPoint]);
-			if (Mice != nullptr)
+			FIntPoint Offset = Step.To - Step.From;
+			FVector Destination = GetPieceLocation(BoardPiece) + FVector(Offset.X * IterationOffset, 0.0f, Offset.Y * IterationOffset);
+			Cells[CellIndex(Step.From)] = INDEX_NONE;
+			MovePiece(BoardPiece, Destination, 1);
+			SetPieceCoordinates(BoardPiece, Step.To);
+			if (FBoardState::IsGoalColumn(Step.To.X))
 			{
-				EType type = Mice->ActorType;
-				// If actor is not a static block
-				if (type != EType::Block)
-				{
-					if (Mice->CanWalk())
-					{
-						Mice->MoveTo(FVector(Mice->GetActorLocation().X, Mice->GetActorLocation().Y, IterationOffset * -2), Mice->Coordinates.Y + 2);
-						BlockMap.Remove(Mice->Coordinates);
-					}
-				}
+				ScoreGoal(BoardPiece, Step.To);
+			}
+			else
+			{
+				Cells[CellIndex(Step.To)] = BoardPiece;
 			}
 		}
+		INC_DWORD_STAT(STAT_SettleStepsPlayed);
+		CSV_CUSTOM_STAT(MiceMen, SettleStepsPlayed, 1, ECsvCustomStatOp::Accumulate);
 	}
+	PendingSteps.SetNum(NumWaiting, false);
+	return PendingSteps.Num() > 0;
+}
+
+// Create and return an array with the coordinates of columns that contain members of a specific team
+TArray<int32> AGrid::TeamColumns(int32 Team)
+{
+	TArray<int32> TeamColumnArray;
+	FBoardState::GetColumnList(Board.GetTeamColumns(EBoardCell(Team)), TeamColumnArray);
+	return TeamColumnArray;
+}
+
+// Score a mouse that walked into a goal column and drop it out of the board once it gets there
+void AGrid::ScoreGoal(int32 Mice, FIntPoint GoalPoint)
+{
+	QueuePieceMove(Mice, FVector(GoalPoint.X * IterationOffset, 0.0f, IterationOffset * -2), GoalPoint.Y + 2);
+
+	INC_DWORD_STAT(STAT_GoalsScored);
+	CSV_CUSTOM_STAT(MiceMen, GoalsScored, 1, ECsvCustomStatOp::Accumulate);
+
+	bool bIsBlue = Pieces[Mice].Type == EType::Blue;
+	ScoredPieces.Add(Mice);
+	AddToScore(bIsBlue);
+	OnGoalScored.Broadcast(bIsBlue, BlueScore, RedScore);
+}
+
+// Index of a cell in the row-major cell array
+int32 AGrid::CellIndex(int32 X, int32 Y) const
+{
+	return Y * FBoardState::Width + X;
+}
+
+int32 AGrid::CellIndex(FIntPoint Coordinates) const
+{
+	return CellIndex(Coordinates.X, Coordinates.Y);
 }
 
 // Increment score of a chosen team
@@ -324,4 +666,181 @@ void AGrid::AddToScore(bool bIsBlue)
 	{
 		RedScore++;
 	}
-}
\ No newline at end of file
+}
+
+FVector AGrid::GetPieceLocation(int32 Piece) const
+{
+	return Pieces[Piece].Location;
+}
+
+// Teleport a piece, any movement it is playing continues from its current start location
+void AGrid::SetPieceLocation(int32 Piece, FVector Location)
+{
+	ApplyPieceLocation(Piece, Location);
+}
+
+void AGrid::SetPieceCoordinates(int32 Piece, FIntPoint Coordinates)
+{
+	FGridPiece& GridPiece = Pieces[Piece];
+	GridPiece.Coordinates = Coordinates;
+	if (GridPiece.Actor != nullptr)
+	{
+		GridPiece.Actor->SetCoordinates(Coordinates);
+	}
+}
+
+// Start movement of a piece towards a given location, distance input is used to determine how fast the piece should move
+void AGrid::MovePiece(int32 Piece, FVector TargetLocation, int32 MovementDistanceInBlocks)
+{
+	FGridPiece& GridPiece = Pieces[Piece];
+	if (GridPiece.Tween != INDEX_NONE) //Only start a movement if the piece is not already moving
+	{
+		return;
+	}
+
+	FPieceTween NewTween;
+	NewTween.Piece = Piece;
+	NewTween.StartLocation = GridPiece.Location;
+	NewTween.TargetLocation = TargetLocation;
+	//Divide movespeed by number of blocks to move through for speed consistency when using linear interpolation
+	NewTween.Speed = MoveSpeed / MovementDistanceInBlocks;
+	NewTween.Alpha = 0.0f;
+	NewTween.bHasNextStage = false;
+	GridPiece.Tween = ActiveTweens.Add(NewTween);
+}
+
+// Chain a movement after the one the piece is playing, or start it right away if the piece is idle
+void AGrid::QueuePieceMove(int32 Piece, FVector TargetLocation, int32 MovementDistanceInBlocks)
+{
+	const int32 Tween = Pieces[Piece].Tween;
+	if (Tween == INDEX_NONE)
+	{
+		MovePiece(Piece, TargetLocation, MovementDistanceInBlocks);
+	}
+	else
+	{
+		FPieceTween& CurrentTween = ActiveTweens[Tween];
+		CurrentTween.bHasNextStage = true;
+		CurrentTween.NextTargetLocation = TargetLocation;
+		CurrentTween.NextSpeed = MoveSpeed / MovementDistanceInBlocks;
+	}
+}
+
+bool AGrid::IsPieceMoving(int32 Piece) const
+{
+	return Pieces[Piece].Tween != INDEX_NONE;
+}
+
+// Toggle highlight of a cheese piece, instanced pieces swap which of their two instances is visible
+void AGrid::TogglePieceHighlight(int32 Piece)
+{
+	FGridPiece& GridPiece = Pieces[Piece];
+	if (GridPiece.Actor != nullptr)
+	{
+		GridPiece.Actor->HighlightToggle();
+	}
+	else if (GridPiece.Type == EType::Block)
+	{
+		GridPiece.bHighlighted = !GridPiece.bHighlighted;
+		UpdateInstance(Piece);
+	}
+}
+
+// Advance every active tween in one pass, instance transforms are only sent to the renderer once per frame in FlushInstances
+void AGrid::AnimatePieces(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AnimatePieces);
+	for (int32 i = ActiveTweens.Num() - 1; i >= 0; --i)
+	{
+		FPieceTween& Tween = ActiveTweens[i];
+		Tween.Alpha = FMath::Min(Tween.Alpha + Tween.Speed * DeltaTime, 1.0f);
+		ApplyPieceLocation(Tween.Piece, FMath::Lerp(Tween.StartLocation, Tween.TargetLocation, Tween.Alpha));
+
+		if (Tween.Alpha >= 1.0f)
+		{
+			if (Tween.bHasNextStage)
+			{
+				Tween.StartLocation = Tween.TargetLocation;
+				Tween.TargetLocation = Tween.NextTargetLocation;
+				Tween.Speed = Tween.NextSpeed;
+				Tween.Alpha = 0.0f;
+				Tween.bHasNextStage = false;
+			}
+			else
+			{
+				RemoveTween(i);
+			}
+		}
+	}
+}
+
+void AGrid::ApplyPieceLocation(int32 Piece, FVector Location)
+{
+	FGridPiece& GridPiece = Pieces[Piece];
+	GridPiece.Location = Location;
+	if (GridPiece.Actor != nullptr)
+	{
+		GridPiece.Actor->SetActorLocation(Location);
+	}
+	else
+	{
+		UpdateInstance(Piece);
+	}
+}
+
+// Remove a finished tween, the last tween takes its slot to keep the array compact
+void AGrid::RemoveTween(int32 Tween)
+{
+	Pieces[ActiveTweens[Tween].Piece].Tween = INDEX_NONE;
+	ActiveTweens.RemoveAtSwap(Tween);
+	if (Tween < ActiveTweens.Num())
+	{
+		Pieces[ActiveTweens[Tween].Piece].Tween = Tween;
+	}
+}
+
+// Write the transform of an instanced piece without marking the render state dirty
+void AGrid::UpdateInstance(int32 Piece)
+{
+	const FGridPiece& GridPiece = Pieces[Piece];
+	const FTransform Visible(GridPiece.Location);
+	const FTransform Hidden(FRotator::ZeroRotator, GridPiece.Location, FVector::ZeroVector);
+
+	if (GridPiece.Type == EType::Block)
+	{
+		CheeseInstances->UpdateInstanceTransform(GridPiece.InstanceIndex, GridPiece.bHighlighted ? Hidden : Visible, true, false, true);
+		HighlightInstances->UpdateInstanceTransform(GridPiece.InstanceIndex, GridPiece.bHighlighted ? Visible : Hidden, true, false, true);
+	}
+	else
+	{
+		GetInstances(GridPiece.Type)->UpdateInstanceTransform(GridPiece.InstanceIndex, Visible, true, false, true);
+	}
+	bInstancesDirty = true;
+}
+
+// Send every instance transform changed since the last flush to the renderer in one batch
+void AGrid::FlushInstances()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlushInstances);
+	if (bInstancesDirty)
+	{
+		bInstancesDirty = false;
+		CheeseInstances->MarkRenderStateDirty();
+		HighlightInstances->MarkRenderStateDirty();
+		BlueInstances->MarkRenderStateDirty();
+		RedInstances->MarkRenderStateDirty();
+	}
+}
+
+UHierarchicalInstancedStaticMeshComponent* AGrid::GetInstances(EType Type) const
+{
+	switch (Type)
+	{
+	case EType::Blue:
+		return BlueInstances;
+	case EType::Red:
+		return RedInstances;
+	default:
+		return CheeseInstances;
+	}
+}
@@ -4,18 +4,68 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "MatchState.h"
+#include "Block.h"
 #include "Grid.generated.h"
 
+class UHierarchicalInstancedStaticMeshComponent;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnGoalScored, bool, bIsBlue, int32, BlueScore, int32, RedScore);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnBoardSettled);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnBoardReset);
+
+// A cheese block or mouse of the grid, drawn either by its own actor or by one instance of the grid's instanced meshes
+USTRUCT()
+struct FGridPiece
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	ABlock* Actor = nullptr;
+
+	EType Type = EType::Block;
+	FIntPoint Coordinates = FIntPoint::ZeroValue;
+	int32 InstanceIndex = INDEX_NONE;
+	bool bHighlighted = false;
+
+	FVector Location = FVector::ZeroVector;
+
+	// Index of the active tween moving this piece, INDEX_NONE while idle
+	int32 Tween = INDEX_NONE;
+};
+
+// Linear movement of one piece, with an optional second stage started once the first one is done
+struct FPieceTween
+{
+	int32 Piece;
+	FVector StartLocation;
+	FVector TargetLocation;
+
+	// Fraction of the movement covered per second
+	float Speed;
+	float Alpha;
+
+	bool bHasNextStage;
+	FVector NextTargetLocation;
+	float NextSpeed;
+};
+
 UCLASS()
 class MICEMEN_API AGrid : public AActor
 {
 	GENERATED_BODY()
+
+	// Dummy Root Component
+	UPROPERTY(Category = Board, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	class USceneComponent* DummyRoot;
 	
 public:	
 	// Sets default values for this actor's properties
 	AGrid();
 
 protected:
+	virtual void PostInitializeComponents() override;
+
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
@@ -23,13 +73,58 @@ public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
-	TMap<FIntPoint, AActor*> BlockMap;
+	// Row-major grid of indices into Pieces, empty cells are INDEX_NONE
+	TArray<int32> Cells;
+
+	UPROPERTY()
+	TArray<FGridPiece> Pieces;
+
+	// Movements of every piece currently moving, advanced together in AnimatePieces
+	TArray<FPieceTween> ActiveTweens;
+
+	int32 CellIndex(int32 X, int32 Y) const;
+	int32 CellIndex(FIntPoint Coordinates) const;
+
+	// Logical board, the pieces in Cells mirror it for rendering
+	FBoardState Board;
+
+	// Settle steps already resolved on Board that are still waiting to be animated
+	TArray<FBoardStep> PendingSteps;
 	
+	// Seed of every random choice of the match, zero picks a new one each time the level starts
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Board Settings")
+	int32 Seed = 0;
+
+	// Drives board generation, FMatchState::Generate draws from a stream with the same seed in the same order
+	FRandomStream RandomStream;
+
+	// Team making the first move, the first draw from RandomStream
+	EBoardCell FirstTeam = EBoardCell::Blue;
+
+	// Seed was zero when the level started, every reset picks a new one as a reloaded level would
+	bool bPickNewSeed = false;
+
+	// Start from a board FBoardGenerator accepted as fair for the seed instead of the classic random board.
+	// The board is generated already settled, so there is no opening settle to watch
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Board Settings")
+	bool bFairBoard = false;
+
+	void PickSeed();
+	void BuildBoard();
+
+	// Start a new match without reloading the level, the pieces of the last one are reused from the pools.
+	// A non-zero seed replaces the one the grid would pick, for matches whose seed comes from elsewhere
+	UFUNCTION(BlueprintCallable, Category = "Board Functions")
+	void ResetBoard(int32 NewSeed = 0);
+
+	void ReleasePieces();
+
 	void GridInitialization();
 	void Populate();
+	void AddPiecesOfType(EBoardCell Type);
 	bool SettleBoard();
 	void PaintColumn(int32 column);
-	void CheckGoal(int32 GoalPosition);
+	void ScoreGoal(int32 Mice, FIntPoint GoalPoint);
 	void AddToScore(bool bIsBlue);
 
 	UFUNCTION(BlueprintCallable, Category = "Board Settings")
@@ -38,6 +133,49 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Board Functions")
 	void MoveColumn(int32 HorizontalCoordinate, bool Upward);
 
+	// Play a move again from its recorded settle steps, animated like MoveColumn but without settling
+	void ReplayMove(const FMoveDelta& Delta, const TArray<FBoardStep>& Steps);
+
+	// Take back the last move, every piece it moved jumps straight back. The grid must be settled
+	void UndoMove(const FMoveDelta& Delta, const TArray<FBoardStep>& Steps);
+
+	// No settle step is waiting to be animated, pieces may still be finishing their last movement
+	bool IsSettled() const;
+
+	// Put every moving piece at the end of its movement right away
+	void FinishTweens();
+
+	// Play every pending settle step and movement out at once, the pieces snap to where the logical board has them
+	void FinishSettle();
+
+	// Every cell holds a piece of the type the logical board has there and the scores agree, once the board is settled
+	bool MatchesBoard() const;
+
+	UFUNCTION(BlueprintCallable, Category = "Movement")
+	void SetTurbo(bool bInTurbo);
+
+	// Animate the pieces of a column one cell up or down and rotate its cells, the logical board is left alone
+	void MoveColumnPieces(int32 HorizontalCoordinate, bool Upward);
+
+	// Rotate the column slice of Cells one cell up or down
+	void RotateColumnCells(int32 HorizontalCoordinate, bool Upward);
+
+	int32 AddPiece(FIntPoint Coordinates, EType Type);
+	FVector GetPieceLocation(int32 Piece) const;
+	void SetPieceLocation(int32 Piece, FVector Location);
+	void SetPieceCoordinates(int32 Piece, FIntPoint Coordinates);
+	void MovePiece(int32 Piece, FVector TargetLocation, int32 MovementDistanceInBlocks);
+	void QueuePieceMove(int32 Piece, FVector TargetLocation, int32 MovementDistanceInBlocks);
+	bool IsPieceMoving(int32 Piece) const;
+	void TogglePieceHighlight(int32 Piece);
+
+	void AnimatePieces(float DeltaTime);
+	void ApplyPieceLocation(int32 Piece, FVector Location);
+	void RemoveTween(int32 Tween);
+	void UpdateInstance(int32 Piece);
+	void FlushInstances();
+	UHierarchicalInstancedStaticMeshComponent* GetInstances(EType Type) const;
+
 //private::
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Board Settings")
@@ -49,14 +187,81 @@ public:
 	UPROPERTY(EditAnywhere, Category = "Board Settings")
 	UStaticMesh* MiceMesh;
 
+	// Draw every piece type with one hierarchical instanced mesh instead of spawning a block actor per piece
+	UPROPERTY(EditAnywhere, Category = "Board Settings")
+	bool bUseInstancedRendering = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	float MoveSpeed = 5.0f;
+
+	// Multiplies the time pieces are animated by, above one plays moves and settles faster
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	float AnimationTimeScale = 1.0f;
+
+	// Skip animation: a move and its whole settle are played out in the call that makes it, for computer
+	// matches and replays that should not wait on the pieces. Turn settled is still raised from the next tick
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Movement")
+	bool bTurbo = false;
+
+	UPROPERTY(VisibleAnywhere, Category = "Rendering")
+	UHierarchicalInstancedStaticMeshComponent* CheeseInstances;
+
+	// Holds a twin of every cheese instance, only one of the two is visible depending on highlighting
+	UPROPERTY(VisibleAnywhere, Category = "Rendering")
+	UHierarchicalInstancedStaticMeshComponent* HighlightInstances;
+
+	UPROPERTY(VisibleAnywhere, Category = "Rendering")
+	UHierarchicalInstancedStaticMeshComponent* BlueInstances;
+
+	UPROPERTY(VisibleAnywhere, Category = "Rendering")
+	UHierarchicalInstancedStaticMeshComponent* RedInstances;
+
+	UPROPERTY()
+	UMaterial* BaseMaterial;
+
+	UPROPERTY()
+	UMaterialInstance* BlueMaterial;
+
+	UPROPERTY()
+	UMaterialInstance* RedMaterial;
+
+	UPROPERTY()
+	UMaterialInstance* HighlightMaterial;
+
+	bool bInstancesDirty = false;
+
+	// Block actors of previous matches, hidden until AddPiece shows them again
+	UPROPERTY()
+	TArray<ABlock*> BlockPool;
+
+	// Hidden instances of previous matches for each piece type, cheese indices come with their highlight twin
+	TArray<int32> FreeInstances[3];
+
 	TArray<int32> TeamColumns(int32 Team);
-	TArray<AActor*> BlueTeam;
-	TArray<AActor*> RedTeam;
+
+	// Mice that scored, in the order they reached their goal, so an undo can bring them back
+	TArray<int32> ScoredPieces;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Board State")
 	int32 BlueScore = 0;
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Board State")
 	int32 RedScore = 0;
 
+	// Called when a mouse walks into a goal column, after the score has been updated
+	UPROPERTY(BlueprintAssignable, Category = "Board Events")
+	FOnGoalScored OnGoalScored;
+
+	// Called when an undo takes a goal back, after the score has been updated
+	UPROPERTY(BlueprintAssignable, Category = "Board Events")
+	FOnGoalScored OnGoalUndone;
+
+	// Called once the opening settle or a move has been played out, every settle step and piece movement is finished
+	UPROPERTY(BlueprintAssignable, Category = "Board Events")
+	FOnBoardSettled OnBoardSettled;
+
+	// Called after ResetBoard built the new match, scores are back to zero
+	UPROPERTY(BlueprintAssignable, Category = "Board Events")
+	FOnBoardReset OnBoardReset;
+
 	bool bCanSettle = true;
 };
@@ -0,0 +1,246 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LargeBoardState.h"
+
+FLargeBoardState::FLargeBoardState(int32 InWidth, int32 InHeight, int32 InMicePerTeam)
+	: Width(InWidth)
+	, Height(InHeight)
+	, MicePerTeam(InMicePerTeam)
+	, BlueGoal(-1)
+	, RedGoal(InWidth)
+{
+	check(Width > 2 && Height > 0);
+	Reset();
+}
+
+void FLargeBoardState::Reset()
+{
+	Cells.Init(EBoardCell::Empty, Width * Height);
+	BlueColumnMice.Init(0, Width);
+	RedColumnMice.Init(0, Width);
+	Candidates.Reset();
+	BlueScore = 0;
+	RedScore = 0;
+}
+
+void FLargeBoardState::GenerateCheese(const FRandomStream& Random)
+{
+	for (int32 x = 0; x < Width; ++x)
+	{
+		for (int32 y = 0; y < Height; ++y)
+		{
+			if (x == 0 || x == Width - 1)
+			{
+				if (y % 3 == 0)
+				{
+					SetCell(x, y, EBoardCell::Cheese);
+				}
+			}
+			else if (Random.RandRange(0, 1) != 0)
+			{
+				SetCell(x, y, EBoardCell::Cheese);
+			}
+		}
+	}
+}
+
+void FLargeBoardState::GenerateMice(const FRandomStream& Random)
+{
+	const EBoardCell Teams[2] = { EBoardCell::Red, EBoardCell::Blue };
+	const int32 FirstColumns[2] = { 0, Width / 2 + 1 };
+	for (int32 Team = 0; Team < 2; ++Team)
+	{
+		int32 NumberOfMice = MicePerTeam;
+		while (NumberOfMice > 0)
+		{
+			const int32 x = Random.RandRange(FirstColumns[Team], FirstColumns[Team] + Width / 2 - 1);
+			const int32 y = Random.RandRange(0, Height - 1);
+			if (IsEmpty(x, y))
+			{
+				SetCell(x, y, Teams[Team]);
+				--NumberOfMice;
+			}
+		}
+	}
+}
+
+bool FLargeBoardState::IsInside(int32 X, int32 Y) const
+{
+	return X >= 0 && X < Width && Y >= 0 && Y < Height;
+}
+
+bool FLargeBoardState::IsEmpty(int32 X, int32 Y) const
+{
+	return IsInside(X, Y) && Cells[CellIndex(X, Y)] == EBoardCell::Empty;
+}
+
+EBoardCell FLargeBoardState::GetCell(int32 X, int32 Y) const
+{
+	return IsInside(X, Y) ? Cells[CellIndex(X, Y)] : EBoardCell::Empty;
+}
+
+void FLargeBoardState::SetCell(int32 X, int32 Y, EBoardCell Cell)
+{
+	check(IsInside(X, Y));
+	EBoardCell& OldCell = Cells[CellIndex(X, Y)];
+	if (OldCell == EBoardCell::Blue)
+	{
+		BlueColumnMice[X]--;
+	}
+	else if (OldCell == EBoardCell::Red)
+	{
+		RedColumnMice[X]--;
+	}
+
+	OldCell = Cell;
+	if (Cell == EBoardCell::Blue)
+	{
+		BlueColumnMice[X]++;
+	}
+	else if (Cell == EBoardCell::Red)
+	{
+		RedColumnMice[X]++;
+	}
+	AddCandidatesAround(X, Y);
+}
+
+void FLargeBoardState::MoveColumn(int32 X, bool bUpward)
+{
+	check(X >= 0 && X < Width);
+	EBoardCell* Column = &Cells[CellIndex(X, 0)];
+	if (bUpward)
+	{
+		const EBoardCell Top = Column[Height - 1];
+		FMemory::Memmove(Column + 1, Column, (Height - 1) * sizeof(EBoardCell));
+		Column[0] = Top;
+	}
+	else
+	{
+		const EBoardCell Bottom = Column[0];
+		FMemory::Memmove(Column, Column + 1, (Height - 1) * sizeof(EBoardCell));
+		Column[Height - 1] = Bottom;
+	}
+
+	// Mice of the column and of both neighbours may start moving anywhere along it
+	for (int32 x = FMath::Max(X - 1, 0); x <= FMath::Min(X + 1, Width - 1); ++x)
+	{
+		if (BlueColumnMice[x] + RedColumnMice[x] > 0)
+		{
+			for (int32 y = 0; y < Height; ++y)
+			{
+				AddCandidate(x, y);
+			}
+		}
+	}
+}
+
+bool FLargeBoardState::MakeStep(int32 X, int32 Y, FBoardStep& OutStep) const
+{
+	const EBoardCell Mouse = GetCell(X, Y);
+	if (Mouse != EBoardCell::Blue && Mouse != EBoardCell::Red)
+	{
+		return false;
+	}
+
+	OutStep.From = FIntPoint(X, Y);
+	OutStep.Mouse = Mouse;
+	if (IsEmpty(X, Y - 1))
+	{
+		OutStep.To = FIntPoint(X, Y - 1);
+		return true;
+	}
+
+	const int32 AheadX = Mouse == EBoardCell::Blue ? X - 1 : X + 1;
+	if (IsGoalColumn(AheadX) || IsEmpty(AheadX, Y))
+	{
+		OutStep.To = FIntPoint(AheadX, Y);
+		return true;
+	}
+	return false;
+}
+
+void FLargeBoardState::ApplyStep(const FBoardStep& Step)
+{
+	SetCell(Step.From.X, Step.From.Y, EBoardCell::Empty);
+	if (IsGoalColumn(Step.To.X))
+	{
+		if (Step.Mouse == EBoardCell::Blue)
+		{
+			BlueScore++;
+		}
+		else
+		{
+			RedScore++;
+		}
+	}
+	else
+	{
+		SetCell(Step.To.X, Step.To.Y, Step.Mouse);
+	}
+}
+
+int32 FLargeBoardState::Settle(TArray<FBoardStep>* OutSteps)
+{
+	int32 Steps = 0;
+	while (Candidates.Num() > 0)
+	{
+		int32 Key;
+		Candidates.HeapPop(Key, false);
+
+		FBoardStep Step;
+		if (MakeStep(Key % Width, Key / Width, Step))
+		{
+			ApplyStep(Step);
+			if (OutSteps != nullptr)
+			{
+				OutSteps->Add(Step);
+			}
+			++Steps;
+		}
+	}
+	return Steps;
+}
+
+void FLargeBoardState::GetTeamColumns(EBoardCell Team, TArray<int32>& OutColumns) const
+{
+	const TArray<int32>& ColumnMice = Team == EBoardCell::Blue ? BlueColumnMice : RedColumnMice;
+	for (int32 x = 0; x < Width; ++x)
+	{
+		if (ColumnMice[x] > 0)
+		{
+			OutColumns.Add(x);
+		}
+	}
+}
+
+int32 FLargeBoardState::CountMice(EBoardCell Team) const
+{
+	const TArray<int32>& ColumnMice = Team == EBoardCell::Blue ? BlueColumnMice : RedColumnMice;
+	int32 Count = 0;
+	for (int32 x = 0; x < Width; ++x)
+	{
+		Count += ColumnMice[x];
+	}
+	return Count;
+}
+
+void FLargeBoardState::AddCandidate(int32 X, int32 Y)
+{
+	if (IsInside(X, Y))
+	{
+		const EBoardCell Cell = Cells[CellIndex(X, Y)];
+		if (Cell == EBoardCell::Blue || Cell == EBoardCell::Red)
+		{
+			Candidates.HeapPush(Y * Width + X);
+		}
+	}
+}
+
+void FLargeBoardState::AddCandidatesAround(int32 X, int32 Y)
+{
+	AddCandidate(X, Y);
+	AddCandidate(X, Y + 1);
+	AddCandidate(X - 1, Y);
+	AddCandidate(X + 1, Y);
+}
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BoardState.h"
+
+/**
+ * Board with dimensions chosen at runtime, following the same rules as TBoardState: cheese and
+ * mice are placed the same way, falling has priority over walking and the lowest, leftmost mouse
+ * always moves first. Meant for stress tests of boards far beyond the 64x64 bitboard limit,
+ * such as 256x256 with thousands of mice.
+ *
+ * Cells are stored column by column. Settling keeps a min heap of cells that may hold a movable
+ * mouse, keyed by row then column, so a cascade costs a heap operation per step instead of a scan
+ * of the whole board. Entries are checked when popped, so stale ones are simply dropped.
+ */
+struct MICEMEN_API FLargeBoardState
+{
+	FLargeBoardState(int32 InWidth, int32 InHeight, int32 InMicePerTeam);
+
+	// Remove every piece and reset scores
+	void Reset();
+
+	// Same placement as TBoardState::GenerateCheese and GenerateMice. There must be room for MicePerTeam mice on each half
+	void GenerateCheese(const FRandomStream& Random);
+	void GenerateMice(const FRandomStream& Random);
+
+	bool IsInside(int32 X, int32 Y) const;
+	bool IsEmpty(int32 X, int32 Y) const;
+	EBoardCell GetCell(int32 X, int32 Y) const;
+	void SetCell(int32 X, int32 Y, EBoardCell Cell);
+
+	// Rotate a column one cell up or down, wrapping around the edge
+	void MoveColumn(int32 X, bool bUpward);
+
+	// Build the step the mouse at X, Y would take, falling has priority over walking
+	bool MakeStep(int32 X, int32 Y, FBoardStep& OutStep) const;
+
+	void ApplyStep(const FBoardStep& Step);
+
+	// Resolve the whole cascade, returns the number of steps taken. Steps are appended to OutSteps if given
+	int32 Settle(TArray<FBoardStep>* OutSteps = nullptr);
+
+	// Append every column holding at least one mouse of the team, lowest first
+	void GetTeamColumns(EBoardCell Team, TArray<int32>& OutColumns) const;
+
+	FORCEINLINE int32 CountColumnMice(EBoardCell Team, int32 X) const { return Team == EBoardCell::Blue ? BlueColumnMice[X] : RedColumnMice[X]; }
+
+	int32 CountMice(EBoardCell Team) const;
+
+	bool IsGoalColumn(int32 X) const { return X == BlueGoal || X == RedGoal; }
+
+	int32 Width;
+	int32 Height;
+	int32 MicePerTeam;
+	int32 BlueGoal;
+	int32 RedGoal;
+
+	int32 BlueScore;
+	int32 RedScore;
+
+private:
+	FORCEINLINE int32 CellIndex(int32 X, int32 Y) const { return X * Height + Y; }
+
+	// Queue the mouse at X, Y, if any, to be checked by the next settle
+	void AddCandidate(int32 X, int32 Y);
+
+	// Queue every mouse whose moves depend on the cell at X, Y: its own, the one above and both neighbours
+	void AddCandidatesAround(int32 X, int32 Y);
+
+	// Cheese, mice or empty, indexed by X * Height + Y
+	TArray<EBoardCell> Cells;
+
+	// Mice of each team per column
+	TArray<int32> BlueColumnMice;
+	TArray<int32> RedColumnMice;
+
+	// Y * Width + X of cells that may hold a movable mouse, every movable mouse is in it
+	TArray<int32> Candidates;
+};
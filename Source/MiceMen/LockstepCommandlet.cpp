@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LockstepCommandlet.h"
+#include "MiceMen.h"
+#include "LockstepSession.h"
+#include "Misc/Parse.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+
+ULockstepCommandlet::ULockstepCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 ULockstepCommandlet::Main(const FString& Params)
+{
+	int32 NumGames = 100;
+	int32 Seed = 1;
+	int32 Port = 7777;
+	int32 MaxPlies = 1000;
+	FParse::Value(*Params, TEXT("games="), NumGames);
+	FParse::Value(*Params, TEXT("seed="), Seed);
+	FParse::Value(*Params, TEXT("port="), Port);
+	FParse::Value(*Params, TEXT("maxplies="), MaxPlies);
+	const bool bFairBoards = FParse::Param(*Params, TEXT("fair"));
+
+	TUniquePtr<FSocketLockstepTransport> HostTransport = MakeUnique<FSocketLockstepTransport>();
+	TUniquePtr<FSocketLockstepTransport> ClientTransport = MakeUnique<FSocketLockstepTransport>();
+	if (!HostTransport->Listen(Port) || !ClientTransport->Connect(TEXT("127.0.0.1"), Port))
+	{
+		return 1;
+	}
+	FLockstepSession Host(MoveTemp(HostTransport), true);
+	FLockstepSession Client(MoveTemp(ClientTransport), false);
+	FLockstepSession* const Sessions[2] = { &Host, &Client };
+
+	// Each side picks its moves from its own stream, only the moves themselves cross the connection
+	const FRandomStream Random[2] = { FRandomStream(Seed), FRandomStream(Seed + 1) };
+	const double StartTime = FPlatformTime::Seconds();
+	int32 NumDesynced = 0;
+	int64 NumTurns = 0;
+	for (int32 Game = 0; Game < NumGames; ++Game)
+	{
+		const int32 GameSeed = int32(HashCombine(uint32(Seed), uint32(Game)));
+		Host.StartMatch(GameSeed, bFairBoards, Game % 2 == 0 ? EBoardCell::Blue : EBoardCell::Red);
+
+		double LastProgress = FPlatformTime::Seconds();
+		int32 LastNumMoves = 0;
+		for (;;)
+		{
+			for (int32 Side = 0; Side < 2; ++Side)
+			{
+				FLockstepSession& Session = *Sessions[Side];
+				Session.Update();
+				FBoardMove Move;
+				while (Session.PopRemoteMove(Move))
+				{
+				}
+				if (Session.IsLocalTurn() && Session.GetNumMoves() < MaxPlies)
+				{
+					FBoardMove Moves[FMatchState::MaxMoves];
+					const int32 NumMoves = Session.GetState().GetLegalMoves(Moves);
+					Session.SubmitMove(Moves[Random[Side].RandRange(0, NumMoves - 1)]);
+				}
+			}
+
+			// Done once the client has the same match and both sides saw every move of it
+			const bool bFailed = Host.GetStatus() > ELockstepStatus::Playing || Client.GetStatus() > ELockstepStatus::Playing;
+			const bool bCaughtUp = Client.GetMatchIndex() == Host.GetMatchIndex() && Client.GetNumMoves() == Host.GetNumMoves()
+				&& (Host.GetState().IsFinished() || Host.GetNumMoves() >= MaxPlies);
+			if (bFailed || bCaughtUp)
+			{
+				break;
+			}
+
+			if (Host.GetNumMoves() != LastNumMoves)
+			{
+				LastNumMoves = Host.GetNumMoves();
+				LastProgress = FPlatformTime::Seconds();
+			}
+			else if (FPlatformTime::Seconds() - LastProgress > 5.0)
+			{
+				UE_LOG(LogMiceMen, Error, TEXT("Lockstep: game %d stalled after %d moves"), Game, LastNumMoves);
+				return 1;
+			}
+			else
+			{
+				FPlatformProcess::Sleep(0.0f);
+			}
+		}
+
+		if (Host.GetStatus() == ELockstepStatus::Disconnected || Client.GetStatus() == ELockstepStatus::Disconnected)
+		{
+			UE_LOG(LogMiceMen, Error, TEXT("Lockstep: disconnected during game %d"), Game);
+			return 1;
+		}
+		if (Host.GetStatus() != ELockstepStatus::Playing || Client.GetStatus() != ELockstepStatus::Playing
+			|| Host.GetState().GetHash() != Client.GetState().GetHash())
+		{
+			++NumDesynced;
+		}
+		NumTurns += Host.GetNumMoves();
+	}
+
+	const double Seconds = FPlatformTime::Seconds() - StartTime;
+	const int64 Bytes = Host.GetBytesSent() + Client.GetBytesSent();
+	UE_LOG(LogMiceMen, Display, TEXT("Lockstep: %d games, %lld turns, %d desynced%s"), NumGames, NumTurns, NumDesynced, bFairBoards ? TEXT(", fair boards") : TEXT(""));
+	UE_LOG(LogMiceMen, Display, TEXT("%lld bytes, %.2f bytes per turn"), Bytes, NumTurns > 0 ? double(Bytes) / NumTurns : 0.0);
+	UE_LOG(LogMiceMen, Display, TEXT("%.2f seconds, %.0f turns per second"), Seconds, NumTurns / FMath::Max(Seconds, 1e-6));
+	return NumDesynced > 0 ? 1 : 0;
+}
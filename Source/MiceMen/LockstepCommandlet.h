@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "LockstepCommandlet.generated.h"
+
+/**
+ * Plays networked matches between two lockstep sessions of this process over TCP on 127.0.0.1, both
+ * picking random legal moves, and checks that they agree after every match. Run with
+ * UE4Editor-Cmd MiceMen.uproject -run=Lockstep -games=100 -seed=1 -port=7777
+ * Options: -games= -seed= -port= -maxplies= -fair
+ */
+UCLASS()
+class MICEMEN_API ULockstepCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	ULockstepCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,226 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LockstepSession.h"
+#include "MiceMen.h"
+#include "BoardGenerator.h"
+
+constexpr uint8 FLockstepSession::Version;
+constexpr int32 FLockstepSession::StartMessageSize;
+constexpr int32 FLockstepSession::MoveMessageSize;
+
+static const uint8 StartMessage = 'S';
+static const uint8 MoveMessage = 'M';
+static const uint8 FairBoardFlag = 1;
+static const uint8 HostPlaysBlueFlag = 2;
+
+static void WriteUInt32(uint8* Bytes, uint32 Value)
+{
+	for (int32 i = 0; i < 4; ++i)
+	{
+		Bytes[i] = uint8(Value >> (i * 8));
+	}
+}
+
+static uint32 ReadUInt32(const uint8* Bytes)
+{
+	uint32 Value = 0;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		Value |= uint32(Bytes[i]) << (i * 8);
+	}
+	return Value;
+}
+
+FLockstepSession::FLockstepSession(TUniquePtr<ILockstepTransport> InTransport, bool bInHost)
+	: Transport(MoveTemp(InTransport))
+	, bHost(bInHost)
+{
+}
+
+uint32 FLockstepSession::Checksum(const FMatchState& InState)
+{
+	const uint64 Hash = InState.GetHash();
+	return uint32(Hash) ^ uint32(Hash >> 32);
+}
+
+void FLockstepSession::StartMatch(int32 InSeed, bool bInFairBoard, EBoardCell InHostTeam)
+{
+	check(bHost);
+	HostTeam = InHostTeam;
+	BeginMatch(MatchIndex + 1, InSeed, bInFairBoard, HostTeam);
+	bStartPending = true;
+	SendStart();
+}
+
+// Both peers build the same starting position the grid does for this seed
+void FLockstepSession::BeginMatch(int32 InMatchIndex, int32 InSeed, bool bInFairBoard, EBoardCell InLocalTeam)
+{
+	MatchIndex = InMatchIndex;
+	Seed = InSeed;
+	bFairBoard = bInFairBoard;
+	LocalTeam = InLocalTeam;
+	if (bFairBoard)
+	{
+		FBoardGenerator().Generate(Seed, State);
+	}
+	else
+	{
+		State.Generate(FRandomStream(Seed));
+	}
+	NumMoves = 0;
+	DesyncTurn = INDEX_NONE;
+	RemoteMoves.Reset();
+	NextRemoteMove = 0;
+	if (Status != ELockstepStatus::Disconnected)
+	{
+		Status = bHost && !Transport->IsConnected() ? ELockstepStatus::Waiting : ELockstepStatus::Playing;
+	}
+}
+
+void FLockstepSession::SendStart()
+{
+	if (!bStartPending || !Transport->IsConnected())
+	{
+		return;
+	}
+	bStartPending = false;
+
+	uint8 Message[StartMessageSize];
+	Message[0] = StartMessage;
+	Message[1] = Version;
+	WriteUInt32(Message + 2, uint32(MatchIndex));
+	WriteUInt32(Message + 6, uint32(Seed));
+	Message[10] = (bFairBoard ? FairBoardFlag : 0) | (HostTeam == EBoardCell::Blue ? HostPlaysBlueFlag : 0);
+	Send(Message, StartMessageSize);
+	Status = ELockstepStatus::Playing;
+}
+
+void FLockstepSession::Send(const uint8* Data, int32 Num)
+{
+	Transport->Send(Data, Num);
+	BytesSent += Num;
+}
+
+void FLockstepSession::Update()
+{
+	if (Status == ELockstepStatus::Disconnected)
+	{
+		return;
+	}
+	if (!Transport->Update())
+	{
+		UE_LOG(LogMiceMen, Warning, TEXT("Lockstep: connection lost after %d moves"), NumMoves);
+		Status = ELockstepStatus::Disconnected;
+		return;
+	}
+	SendStart();
+
+	const int32 PreviousNum = ReceiveBuffer.Num();
+	Transport->Receive(ReceiveBuffer);
+	BytesReceived += ReceiveBuffer.Num() - PreviousNum;
+	ReadMessages();
+}
+
+void FLockstepSession::ReadMessages()
+{
+	int32 Offset = 0;
+	while (Offset < ReceiveBuffer.Num())
+	{
+		const uint8* Message = ReceiveBuffer.GetData() + Offset;
+		const int32 Available = ReceiveBuffer.Num() - Offset;
+		if (Message[0] == StartMessage && !bHost)
+		{
+			// Other versions may lay out their messages differently, so nothing after the version is read
+			if (Available >= 2 && Message[1] != Version)
+			{
+				UE_LOG(LogMiceMen, Error, TEXT("Lockstep: the host runs protocol version %d, this build runs %d"), Message[1], Version);
+				MarkDesynced();
+				Offset = ReceiveBuffer.Num();
+				break;
+			}
+			if (Available < StartMessageSize)
+			{
+				break;
+			}
+			const bool bHostPlaysBlue = (Message[10] & HostPlaysBlueFlag) != 0;
+			BeginMatch(int32(ReadUInt32(Message + 2)), int32(ReadUInt32(Message + 6)), (Message[10] & FairBoardFlag) != 0,
+				bHostPlaysBlue ? EBoardCell::Red : EBoardCell::Blue);
+			Offset += StartMessageSize;
+		}
+		else if (Message[0] == MoveMessage)
+		{
+			if (Available < MoveMessageSize)
+			{
+				break;
+			}
+			Offset += MoveMessageSize;
+			if (Status != ELockstepStatus::Playing || Message[1] != uint8(MatchIndex))
+			{
+				// Nothing is trusted after a desync, moves of a match the host replaced are stale
+				continue;
+			}
+
+			const FBoardMove Move = FBoardMove::Decode(Message[3]);
+			if (Message[2] != uint8(NumMoves) || State.SideToMove == LocalTeam || State.IsFinished() || !State.IsLegalMove(Move))
+			{
+				MarkDesynced();
+				continue;
+			}
+			State.ApplyMove(Move);
+			++NumMoves;
+			RemoteMoves.Add(Move);
+			if (Checksum(State) != ReadUInt32(Message + 4))
+			{
+				MarkDesynced();
+			}
+		}
+		else
+		{
+			UE_LOG(LogMiceMen, Error, TEXT("Lockstep: unknown message %d"), Message[0]);
+			MarkDesynced();
+			Offset = ReceiveBuffer.Num();
+		}
+	}
+	ReceiveBuffer.RemoveAt(0, Offset, false);
+}
+
+void FLockstepSession::MarkDesynced()
+{
+	if (Status == ELockstepStatus::Desynced)
+	{
+		return;
+	}
+	UE_LOG(LogMiceMen, Error, TEXT("Lockstep: desync on turn %d of match %d, seed %d"), NumMoves, MatchIndex, Seed);
+	Status = ELockstepStatus::Desynced;
+	DesyncTurn = NumMoves;
+}
+
+bool FLockstepSession::SubmitMove(FBoardMove Move)
+{
+	if (!IsLocalTurn() || !State.IsLegalMove(Move))
+	{
+		return false;
+	}
+	State.ApplyMove(Move);
+
+	uint8 Message[MoveMessageSize];
+	Message[0] = MoveMessage;
+	Message[1] = uint8(MatchIndex);
+	Message[2] = uint8(NumMoves);
+	Message[3] = Move.Encode();
+	WriteUInt32(Message + 4, Checksum(State));
+	Send(Message, MoveMessageSize);
+	++NumMoves;
+	return true;
+}
+
+bool FLockstepSession::PopRemoteMove(FBoardMove& OutMove)
+{
+	if (NextRemoteMove >= RemoteMoves.Num())
+	{
+		return false;
+	}
+	OutMove = RemoteMoves[NextRemoteMove++];
+	return true;
+}
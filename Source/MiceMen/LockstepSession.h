@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MatchState.h"
+#include "LockstepTransport.h"
+
+enum class ELockstepStatus : uint8
+{
+	// The host has no peer yet, or the peer has not received a match from the host
+	Waiting,
+	Playing,
+	// The peer played a move the rules don't allow here, or its position stopped matching ours
+	Desynced,
+	Disconnected
+};
+
+/**
+ * One side of a networked match played in lockstep. Both peers run the same deterministic rules on
+ * their own FMatchState, so all that crosses the wire is the match setup and one move per turn:
+ *
+ *   Start  'S' Version Match(4) Seed(4) Flags                  11 bytes, sent by the host
+ *   Move   'M' Match Turn Move Checksum(4)                       8 bytes, sent by the side that moved
+ *
+ * Numbers are little endian. Flags bit 0 is set for fair boards, bit 1 when the host plays blue.
+ * The host numbers the matches it starts and the peer takes the number over from Start, so both agree
+ * even when the host started several before the peer connected. Moves carry the match number and
+ * the turn modulo 256, so moves still in flight when the host starts a new match are told apart and dropped. Move is FBoardMove::Encode. Checksum folds the hash of the position after the move, so the
+ * receiver catches a desync on the very turn it happens. The host can send Start again at any time
+ * to begin a new match on the same connection.
+ */
+class MICEMEN_API FLockstepSession
+{
+public:
+	static constexpr uint8 Version = 2;
+	static constexpr int32 StartMessageSize = 11;
+	static constexpr int32 MoveMessageSize = 8;
+
+	explicit FLockstepSession(TUniquePtr<ILockstepTransport> InTransport, bool bInHost);
+
+	// Host only: begin a new match, the peer gets it as soon as it is connected
+	void StartMatch(int32 Seed, bool bFairBoard, EBoardCell HostTeam = EBoardCell::Blue);
+
+	// Pump the transport and take in the peer's messages, never blocks
+	void Update();
+
+	// Play a move of the local team, returns false if it is not the local team's turn or the move is not legal
+	bool SubmitMove(FBoardMove Move);
+
+	// Moves of the peer in the order they were played, already applied to GetState
+	bool PopRemoteMove(FBoardMove& OutMove);
+
+	ELockstepStatus GetStatus() const { return Status; }
+	bool IsHost() const { return bHost; }
+	bool IsLocalTurn() const { return Status == ELockstepStatus::Playing && !State.IsFinished() && State.SideToMove == LocalTeam; }
+	EBoardCell GetLocalTeam() const { return LocalTeam; }
+
+	// Position after every move played so far, remote moves included even before the game popped them
+	const FMatchState& GetState() const { return State; }
+
+	int32 GetSeed() const { return Seed; }
+	bool IsFairBoard() const { return bFairBoard; }
+
+	// Number the host gave the current match, it grows with every match so the game can tell when the host began a new one
+	int32 GetMatchIndex() const { return MatchIndex; }
+	int32 GetNumMoves() const { return NumMoves; }
+
+	// Turn the desync was found on, INDEX_NONE while in sync
+	int32 GetDesyncTurn() const { return DesyncTurn; }
+
+	int64 GetBytesSent() const { return BytesSent; }
+	int64 GetBytesReceived() const { return BytesReceived; }
+
+	static uint32 Checksum(const FMatchState& InState);
+
+private:
+	void BeginMatch(int32 InMatchIndex, int32 InSeed, bool bInFairBoard, EBoardCell InLocalTeam);
+	void SendStart();
+	void Send(const uint8* Data, int32 Num);
+	void ReadMessages();
+	void MarkDesynced();
+
+	TUniquePtr<ILockstepTransport> Transport;
+	bool bHost;
+	bool bStartPending = false;
+	EBoardCell HostTeam = EBoardCell::Blue;
+
+	ELockstepStatus Status = ELockstepStatus::Waiting;
+	FMatchState State;
+	EBoardCell LocalTeam = EBoardCell::Blue;
+	int32 Seed = 0;
+	bool bFairBoard = false;
+	int32 MatchIndex = 0;
+	int32 NumMoves = 0;
+	int32 DesyncTurn = INDEX_NONE;
+
+	TArray<FBoardMove> RemoteMoves;
+	int32 NextRemoteMove = 0;
+
+	// Received bytes not yet making up a whole message
+	TArray<uint8> ReceiveBuffer;
+
+	int64 BytesSent = 0;
+	int64 BytesReceived = 0;
+};
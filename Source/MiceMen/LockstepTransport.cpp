@@ -0,0 +1,162 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LockstepTransport.h"
+#include "MiceMen.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+#include "Common/TcpSocketBuilder.h"
+
+FSocketLockstepTransport::~FSocketLockstepTransport()
+{
+	Close();
+}
+
+bool FSocketLockstepTransport::Listen(int32 Port)
+{
+	Close();
+	ListenSocket = FTcpSocketBuilder(TEXT("MiceMenLockstepListen"))
+		.AsReusable()
+		.AsNonBlocking()
+		.BoundToPort(Port)
+		.Listening(1);
+	if (ListenSocket == nullptr)
+	{
+		UE_LOG(LogMiceMen, Error, TEXT("Lockstep: could not listen on port %d"), Port);
+		return false;
+	}
+	return true;
+}
+
+bool FSocketLockstepTransport::Connect(const FString& Address, int32 Port)
+{
+	Close();
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	TSharedRef<FInternetAddr> PeerAddress = SocketSubsystem->CreateInternetAddr();
+	bool bValidAddress = false;
+	PeerAddress->SetIp(*Address, bValidAddress);
+	PeerAddress->SetPort(Port);
+	if (!bValidAddress)
+	{
+		UE_LOG(LogMiceMen, Error, TEXT("Lockstep: %s is not an address"), *Address);
+		return false;
+	}
+
+	Socket = FTcpSocketBuilder(TEXT("MiceMenLockstep")).AsNonBlocking();
+	if (Socket == nullptr)
+	{
+		return false;
+	}
+	Socket->SetNoDelay(true);
+
+	// A non-blocking connect reports that it is in progress, Update sees when it is done
+	Socket->Connect(*PeerAddress);
+	return true;
+}
+
+void FSocketLockstepTransport::Close()
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	for (FSocket** OpenSocket : { &ListenSocket, &Socket })
+	{
+		if (*OpenSocket != nullptr)
+		{
+			(*OpenSocket)->Close();
+			SocketSubsystem->DestroySocket(*OpenSocket);
+			*OpenSocket = nullptr;
+		}
+	}
+	bConnected = false;
+	bLost = false;
+	SendBuffer.Reset();
+}
+
+bool FSocketLockstepTransport::Update()
+{
+	if (bLost)
+	{
+		return false;
+	}
+
+	if (Socket == nullptr && ListenSocket != nullptr)
+	{
+		bool bPending = false;
+		if (ListenSocket->HasPendingConnection(bPending) && bPending)
+		{
+			Socket = ListenSocket->Accept(TEXT("MiceMenLockstep"));
+			if (Socket != nullptr)
+			{
+				Socket->SetNonBlocking(true);
+				Socket->SetNoDelay(true);
+			}
+		}
+	}
+	if (Socket == nullptr)
+	{
+		return true;
+	}
+
+	if (!bConnected)
+	{
+		// A connecting socket turns writable once the connection is made, a failed one shows up on the first read
+		bConnected = Socket->Wait(ESocketWaitConditions::WaitForWrite, FTimespan::Zero());
+	}
+	if (bConnected)
+	{
+		Flush();
+	}
+	return !bLost;
+}
+
+void FSocketLockstepTransport::Send(const uint8* Data, int32 Num)
+{
+	SendBuffer.Append(Data, Num);
+	if (bConnected)
+	{
+		Flush();
+	}
+}
+
+void FSocketLockstepTransport::Flush()
+{
+	while (SendBuffer.Num() > 0)
+	{
+		int32 BytesSent = 0;
+		if (!Socket->Send(SendBuffer.GetData(), SendBuffer.Num(), BytesSent))
+		{
+			// Would block, the rest goes out on the next update
+			if (ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() != SE_EWOULDBLOCK)
+			{
+				bLost = true;
+			}
+			return;
+		}
+		SendBuffer.RemoveAt(0, BytesSent, false);
+	}
+}
+
+void FSocketLockstepTransport::Receive(TArray<uint8>& OutBytes)
+{
+	if (!bConnected || bLost)
+	{
+		return;
+	}
+
+	uint8 Buffer[256];
+	while (Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::Zero()))
+	{
+		// Stream sockets fail a read once the peer closed the connection, one that would block succeeds with nothing
+		int32 BytesRead = 0;
+		if (!Socket->Recv(Buffer, sizeof(Buffer), BytesRead))
+		{
+			bLost = true;
+			return;
+		}
+		if (BytesRead == 0)
+		{
+			return;
+		}
+		OutBytes.Append(Buffer, BytesRead);
+	}
+}
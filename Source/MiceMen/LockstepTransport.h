@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FSocket;
+
+// Reliable, ordered byte stream between the two peers of a lockstep match
+class MICEMEN_API ILockstepTransport
+{
+public:
+	virtual ~ILockstepTransport() {}
+
+	// Finish connecting and flush queued bytes, never blocks. Returns false once the connection is lost
+	virtual bool Update() = 0;
+
+	virtual bool IsConnected() const = 0;
+
+	// Queue bytes for the peer, they go out on this or a later Update
+	virtual void Send(const uint8* Data, int32 Num) = 0;
+
+	// Append every byte that arrived since the last call, never blocks
+	virtual void Receive(TArray<uint8>& OutBytes) = 0;
+};
+
+/**
+ * TCP through the platform socket subsystem, polled from the caller's thread without ever blocking.
+ * One side listens and accepts a single peer, the other connects, so both ends of a match can run
+ * in the same process over 127.0.0.1.
+ */
+class MICEMEN_API FSocketLockstepTransport : public ILockstepTransport
+{
+public:
+	virtual ~FSocketLockstepTransport();
+
+	// Wait for one peer on Port, Update accepts it
+	bool Listen(int32 Port);
+
+	// Start connecting to a listening peer, Update finishes it
+	bool Connect(const FString& Address, int32 Port);
+
+	void Close();
+
+	virtual bool Update() override;
+	virtual bool IsConnected() const override { return bConnected; }
+	virtual void Send(const uint8* Data, int32 Num) override;
+	virtual void Receive(TArray<uint8>& OutBytes) override;
+
+private:
+	void Flush();
+
+	FSocket* ListenSocket = nullptr;
+	FSocket* Socket = nullptr;
+	bool bConnected = false;
+	bool bLost = false;
+
+	// Bytes the socket would not take yet
+	TArray<uint8> SendBuffer;
+};
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MatchReplay.h"
+#include "BoardGenerator.h"
+#include "Misc/FileHelper.h"
+
+constexpr uint8 FMatchReplay::Version;
+
+static const int32 HeaderSize = 9;
+static const int32 Version1HeaderSize = 8;
+
+void FMatchReplay::Reset(int32 InSeed, bool bInFairBoard)
+{
+	Seed = InSeed;
+	bFairBoard = bInFairBoard;
+	Moves.Reset();
+}
+
+bool FMatchReplay::Seek(int32 NumMoves, FMatchState& OutState) const
+{
+	if (bFairBoard)
+	{
+		FBoardGenerator().Generate(Seed, OutState);
+	}
+	else
+	{
+		OutState.Generate(FRandomStream(Seed));
+	}
+
+	const int32 LastMove = NumMoves < 0 ? Moves.Num() : FMath::Min(NumMoves, Moves.Num());
+	for (int32 i = 0; i < LastMove; ++i)
+	{
+		const FBoardMove Move = FBoardMove::Decode(Moves[i]);
+		if (OutState.IsFinished() || !OutState.IsLegalMove(Move))
+		{
+			return false;
+		}
+		OutState.ApplyMove(Move);
+	}
+	return true;
+}
+
+void FMatchReplay::Save(TArray<uint8>& OutBytes) const
+{
+	OutBytes.Reset(HeaderSize + Moves.Num());
+	OutBytes.Add('M');
+	OutBytes.Add('M');
+	OutBytes.Add('R');
+	OutBytes.Add(Version);
+	for (int32 Shift = 0; Shift < 32; Shift += 8)
+	{
+		OutBytes.Add(uint8(uint32(Seed) >> Shift));
+	}
+	OutBytes.Add(bFairBoard ? 1 : 0);
+	OutBytes.Append(Moves);
+}
+
+bool FMatchReplay::Load(const TArray<uint8>& Bytes)
+{
+	if (Bytes.Num() < Version1HeaderSize || Bytes[0] != 'M' || Bytes[1] != 'M' || Bytes[2] != 'R' || (Bytes[3] != 1 && Bytes[3] != Version))
+	{
+		return false;
+	}
+	const int32 LoadedHeaderSize = Bytes[3] == 1 ? Version1HeaderSize : HeaderSize;
+	if (Bytes.Num() < LoadedHeaderSize)
+	{
+		return false;
+	}
+
+	uint32 LoadedSeed = 0;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		LoadedSeed |= uint32(Bytes[4 + i]) << (i * 8);
+	}
+	Reset(int32(LoadedSeed), LoadedHeaderSize > Version1HeaderSize && Bytes[Version1HeaderSize] != 0);
+	Moves.Append(Bytes.GetData() + LoadedHeaderSize, Bytes.Num() - LoadedHeaderSize);
+	return true;
+}
+
+bool FMatchReplay::SaveToFile(const FString& Filename) const
+{
+	TArray<uint8> Bytes;
+	Save(Bytes);
+	return FFileHelper::SaveArrayToFile(Bytes, *Filename);
+}
+
+bool FMatchReplay::LoadFromFile(const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	return FFileHelper::LoadFileToArray(Bytes, *Filename) && Load(Bytes);
+}
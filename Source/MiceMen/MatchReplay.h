@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MatchState.h"
+
+/**
+ * A whole match stored as the seed its board was generated from plus one byte per move,
+ * see FBoardMove::Encode. Replaying the moves through FMatchState rebuilds any position
+ * of the match exactly, without actors or animation.
+ */
+struct MICEMEN_API FMatchReplay
+{
+	// Bumped whenever the rules or the board generation change in a way that breaks older replays
+	static constexpr uint8 Version = 2;
+
+	int32 Seed = 0;
+
+	// The board came from FBoardGenerator with its default settings rather than FMatchState::Generate
+	bool bFairBoard = false;
+
+	TArray<uint8> Moves;
+
+	void Reset(int32 InSeed, bool bInFairBoard = false);
+	void Record(FBoardMove Move) { Moves.Add(Move.Encode()); }
+	int32 Num() const { return Moves.Num(); }
+
+	// Rebuild the match after its first NumMoves moves, or all of them if negative.
+	// Returns false if the replay holds a move the rules don't allow, OutState is left after the last legal move.
+	bool Seek(int32 NumMoves, FMatchState& OutState) const;
+
+	// Binary layout: 'M' 'M' 'R' Version, the seed as 4 little endian bytes, a byte set for fair boards, then the moves.
+	// Version 1 files have no board byte and always start from the classic board
+	void Save(TArray<uint8>& OutBytes) const;
+	bool Load(const TArray<uint8>& Bytes);
+
+	bool SaveToFile(const FString& Filename) const;
+	bool LoadFromFile(const FString& Filename);
+};
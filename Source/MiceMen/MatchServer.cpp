@@ -0,0 +1,300 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MatchServer.h"
+#include "BoardGenerator.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+constexpr int32 FLatencyHistogram::SubBuckets;
+constexpr int32 FLatencyHistogram::NumBuckets;
+
+FLatencyHistogram::FLatencyHistogram()
+{
+	FMemory::Memzero(Counts);
+}
+
+void FLatencyHistogram::Add(double Seconds)
+{
+	// The power of two picks the group, the next three bits the bucket within it
+	const uint64 Microseconds = uint64(FMath::Max(Seconds, 0.0) * 1000000.0) + 1;
+	const int32 Log = int32(FMath::FloorLog2_64(Microseconds));
+	const int32 Sub = Log >= 3 ? int32(Microseconds >> (Log - 3)) & (SubBuckets - 1) : int32(Microseconds << (3 - Log)) & (SubBuckets - 1);
+	++Counts[FMath::Min(Log * SubBuckets + Sub, NumBuckets - 1)];
+	++Num;
+	MaxSeconds = FMath::Max(MaxSeconds, Seconds);
+}
+
+void FLatencyHistogram::Merge(const FLatencyHistogram& Other)
+{
+	for (int32 i = 0; i < NumBuckets; ++i)
+	{
+		Counts[i] += Other.Counts[i];
+	}
+	Num += Other.Num;
+	MaxSeconds = FMath::Max(MaxSeconds, Other.MaxSeconds);
+}
+
+double FLatencyHistogram::GetPercentile(double Fraction) const
+{
+	if (Num == 0)
+	{
+		return 0.0;
+	}
+	const int64 Rank = FMath::Max<int64>(int64(Fraction * Num + 0.5), 1);
+	int64 Seen = 0;
+	for (int32 i = 0; i < NumBuckets; ++i)
+	{
+		Seen += Counts[i];
+		if (Seen >= Rank)
+		{
+			const int32 Log = i / SubBuckets;
+			const double Upper = double(uint64(1) << Log) * (1.0 + double(i % SubBuckets + 1) / SubBuckets);
+			return FMath::Min(Upper / 1000000.0, MaxSeconds);
+		}
+	}
+	return MaxSeconds;
+}
+
+FMatchServer::FMatchServer(const FMatchServerSettings& InSettings)
+	: Settings(InSettings)
+	, NextMatch(0)
+{
+	const int32 NumShards = Settings.NumShards > 0 ? Settings.NumShards
+		: Settings.bSingleThreaded ? 1 : FPlatformMisc::NumberOfWorkerThreadsToSpawn() + 1;
+	for (int32 i = 0; i < NumShards; ++i)
+	{
+		Shards.Add(MakeUnique<FShard>());
+	}
+}
+
+FMatchServer::~FMatchServer()
+{
+}
+
+int32 FMatchServer::CreateMatch(int32 Seed, bool bFairBoard)
+{
+	FCommand Command;
+	Command.Match = NextMatch++;
+	Command.Seed = Seed;
+	Command.bCreate = true;
+	Command.bFairBoard = bFairBoard;
+	Command.Team = EBoardCell::Blue;
+	Command.SubmitCycles = FPlatformTime::Cycles64();
+
+	FShard& Shard = *Shards[Command.Match % Shards.Num()];
+	FScopeLock Lock(&Shard.InboxLock);
+	Shard.Inbox.Add(Command);
+	return Command.Match;
+}
+
+void FMatchServer::SubmitMove(int32 Match, EBoardCell Team, FBoardMove Move)
+{
+	FCommand Command;
+	Command.Match = Match;
+	Command.Seed = 0;
+	Command.bCreate = false;
+	Command.bFairBoard = false;
+	Command.Team = Team;
+	Command.Move = Move;
+	Command.SubmitCycles = FPlatformTime::Cycles64();
+
+	FShard& Shard = *Shards[FMath::Max(Match, 0) % Shards.Num()];
+	FScopeLock Lock(&Shard.InboxLock);
+	Shard.Inbox.Add(Command);
+}
+
+void FMatchServer::Update()
+{
+	const double Now = FPlatformTime::Seconds();
+	ParallelFor(Shards.Num(), [this, Now](int32 Index)
+	{
+		UpdateShard(*Shards[Index], Now);
+	}, Settings.bSingleThreaded);
+}
+
+void FMatchServer::UpdateShard(FShard& Shard, double Now)
+{
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// Swap the inbox out so submitting threads wait on the lock only for the swap
+	{
+		FScopeLock Lock(&Shard.InboxLock);
+		Swap(Shard.Inbox, Shard.Commands);
+	}
+	for (const FCommand& Command : Shard.Commands)
+	{
+		if (Command.bCreate)
+		{
+			StartMatch(Shard, Command, Now);
+		}
+		else
+		{
+			PlayMove(Shard, Command, Now);
+		}
+	}
+	Shard.Commands.Reset();
+
+	// Matches are removed by swapping, walking backwards visits every one once
+	for (int32 Slot = Shard.Matches.Num() - 1; Slot >= 0; --Slot)
+	{
+		const FServerMatch& Match = Shard.Matches[Slot];
+		if (Now >= Match.TurnDeadline)
+		{
+			++Shard.Stats.Timeouts;
+			const bool bBlueLost = Match.State.SideToMove == EBoardCell::Blue;
+			FinishMatch(Shard, Slot, bBlueLost ? EMatchResult::RedWins : EMatchResult::BlueWins, EMatchEnd::Timeout);
+		}
+	}
+
+	if (Shard.Events.Num() > 0)
+	{
+		FScopeLock Lock(&Shard.OutboxLock);
+		Shard.Outbox.Append(Shard.Events);
+	}
+	Shard.Events.Reset();
+
+	Shard.Stats.ActiveMatches = Shard.Matches.Num();
+	Shard.Stats.ShardUpdateTime.Add((FPlatformTime::Cycles64() - StartCycles) * FPlatformTime::GetSecondsPerCycle64());
+}
+
+void FMatchServer::StartMatch(FShard& Shard, const FCommand& Command, double Now)
+{
+	FServerMatch Match;
+	Match.Id = Command.Match;
+	Match.Plies = 0;
+	Match.TurnDeadline = Now + Settings.TurnSeconds;
+	if (Command.bFairBoard)
+	{
+		FBoardGenerator().Generate(Command.Seed, Match.State);
+	}
+	else
+	{
+		Match.State.Generate(FRandomStream(Command.Seed));
+	}
+
+	const int32 Index = Command.Match / Shards.Num();
+	if (Shard.Slots.Num() <= Index)
+	{
+		Shard.Slots.Reserve(FMath::Max(Index + 1, Shard.Slots.Num() * 2));
+		while (Shard.Slots.Num() <= Index)
+		{
+			Shard.Slots.Add(INDEX_NONE);
+		}
+	}
+	Shard.Slots[Index] = Shard.Matches.Add(Match);
+	++Shard.Stats.MatchesStarted;
+
+	FMatchServerEvent& Event = Shard.Events[Shard.Events.AddDefaulted()];
+	Event.Match = Command.Match;
+	Event.Type = EMatchServerEvent::Started;
+	Event.Team = Match.State.SideToMove;
+
+	// The opening settle can decide a match before anyone moved
+	if (Match.State.IsFinished())
+	{
+		FinishMatch(Shard, Shard.Slots[Index], Match.State.GetResult(), EMatchEnd::Played);
+	}
+}
+
+void FMatchServer::PlayMove(FShard& Shard, const FCommand& Command, double Now)
+{
+	const int32 Index = Command.Match / Shards.Num();
+	const int32 Slot = Command.Match >= 0 && Index < Shard.Slots.Num() ? Shard.Slots[Index] : INDEX_NONE;
+
+	EMatchRejection Rejection = EMatchRejection::None;
+	if (Slot == INDEX_NONE)
+	{
+		Rejection = EMatchRejection::NotPlaying;
+	}
+	else if (Shard.Matches[Slot].State.SideToMove != Command.Team)
+	{
+		Rejection = EMatchRejection::NotYourTurn;
+	}
+	else if (!Shard.Matches[Slot].State.IsLegalMove(Command.Move))
+	{
+		Rejection = EMatchRejection::IllegalMove;
+	}
+
+	FMatchServerEvent& Event = Shard.Events[Shard.Events.AddDefaulted()];
+	Event.Match = Command.Match;
+	Event.Team = Command.Team;
+	Event.Move = Command.Move;
+	if (Rejection != EMatchRejection::None)
+	{
+		Event.Type = EMatchServerEvent::Rejected;
+		Event.Rejection = Rejection;
+		++Shard.Stats.MovesRejected;
+		return;
+	}
+	Event.Type = EMatchServerEvent::Moved;
+
+	FServerMatch& Match = Shard.Matches[Slot];
+	Match.State.ApplyMove(Command.Move);
+	++Match.Plies;
+	Match.TurnDeadline = Now + Settings.TurnSeconds;
+	++Shard.Stats.MovesPlayed;
+	Shard.Stats.MoveLatency.Add((FPlatformTime::Cycles64() - Command.SubmitCycles) * FPlatformTime::GetSecondsPerCycle64());
+
+	if (Match.State.IsFinished())
+	{
+		FinishMatch(Shard, Slot, Match.State.GetResult(), EMatchEnd::Played);
+	}
+	else if (Match.Plies >= Settings.MaxPlies)
+	{
+		FinishMatch(Shard, Slot, EMatchResult::Draw, EMatchEnd::MoveLimit);
+	}
+}
+
+void FMatchServer::FinishMatch(FShard& Shard, int32 Slot, EMatchResult Result, EMatchEnd End)
+{
+	const FServerMatch& Match = Shard.Matches[Slot];
+	FMatchServerEvent& Event = Shard.Events[Shard.Events.AddDefaulted()];
+	Event.Match = Match.Id;
+	Event.Type = EMatchServerEvent::Finished;
+	Event.Team = Match.State.SideToMove;
+	Event.Result = Result;
+	Event.End = End;
+	Event.Plies = Match.Plies;
+	Event.BlueScore = Match.State.Board.BlueScore;
+	Event.RedScore = Match.State.Board.RedScore;
+	++Shard.Stats.MatchesFinished;
+
+	// The last match takes the slot, the ended one is forgotten
+	Shard.Slots[Match.Id / Shards.Num()] = INDEX_NONE;
+	Shard.Matches.RemoveAtSwap(Slot);
+	if (Slot < Shard.Matches.Num())
+	{
+		Shard.Slots[Shard.Matches[Slot].Id / Shards.Num()] = Slot;
+	}
+}
+
+void FMatchServer::PopEvents(TArray<FMatchServerEvent>& OutEvents)
+{
+	for (const TUniquePtr<FShard>& Shard : Shards)
+	{
+		FScopeLock Lock(&Shard->OutboxLock);
+		OutEvents.Append(Shard->Outbox);
+		Shard->Outbox.Reset();
+	}
+}
+
+FMatchServerStats FMatchServer::GetStats() const
+{
+	FMatchServerStats Stats;
+	for (const TUniquePtr<FShard>& Shard : Shards)
+	{
+		const FMatchServerStats& ShardStats = Shard->Stats;
+		Stats.ActiveMatches += ShardStats.ActiveMatches;
+		Stats.MatchesStarted += ShardStats.MatchesStarted;
+		Stats.MatchesFinished += ShardStats.MatchesFinished;
+		Stats.MovesPlayed += ShardStats.MovesPlayed;
+		Stats.MovesRejected += ShardStats.MovesRejected;
+		Stats.Timeouts += ShardStats.Timeouts;
+		Stats.MoveLatency.Merge(ShardStats.MoveLatency);
+		Stats.ShardUpdateTime.Merge(ShardStats.ShardUpdateTime);
+	}
+	return Stats;
+}
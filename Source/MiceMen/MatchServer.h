@@ -0,0 +1,185 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MatchState.h"
+#include "Templates/Atomic.h"
+#include "HAL/CriticalSection.h"
+
+struct FMatchServerSettings
+{
+	// Groups of matches updated by one worker each, zero uses one per worker thread
+	int32 NumShards = 0;
+
+	// A team that takes longer than this over a move loses the match
+	float TurnSeconds = 30.0f;
+
+	// Matches still going after this many moves end as draws
+	int32 MaxPlies = 1000;
+
+	bool bSingleThreaded = false;
+};
+
+enum class EMatchServerEvent : uint8
+{
+	// The match exists and Team moves first
+	Started,
+	// Team played Move, it is the other team's turn unless a Finished event follows
+	Moved,
+	// Team's Move was refused, see Rejection. The match goes on as if it had not been sent
+	Rejected,
+	Finished
+};
+
+enum class EMatchRejection : uint8
+{
+	None,
+	// No such match, or it is already over
+	NotPlaying,
+	NotYourTurn,
+	// The move breaks the rules AControllerPawn::RemoveInvalidColumn applies
+	IllegalMove
+};
+
+enum class EMatchEnd : uint8
+{
+	Played,
+	// The team to move ran out of time and lost
+	Timeout,
+	// MaxPlies was reached
+	MoveLimit
+};
+
+// Everything clients learn from the server, events of one match always come in the order they happened
+struct FMatchServerEvent
+{
+	int32 Match = INDEX_NONE;
+	EMatchServerEvent Type = EMatchServerEvent::Started;
+	EBoardCell Team = EBoardCell::Blue;
+	FBoardMove Move;
+	EMatchRejection Rejection = EMatchRejection::None;
+
+	// Filled in on Finished
+	EMatchResult Result = EMatchResult::Playing;
+	EMatchEnd End = EMatchEnd::Played;
+	int32 Plies = 0;
+	int32 BlueScore = 0;
+	int32 RedScore = 0;
+};
+
+// Log-linear histogram of latencies, eight buckets per power of two microseconds so percentiles are within about 10%
+struct MICEMEN_API FLatencyHistogram
+{
+	static constexpr int32 SubBuckets = 8;
+	static constexpr int32 NumBuckets = 32 * SubBuckets;
+
+	FLatencyHistogram();
+
+	void Add(double Seconds);
+	void Merge(const FLatencyHistogram& Other);
+
+	// Upper bound of the bucket holding the given fraction of the samples, in seconds
+	double GetPercentile(double Fraction) const;
+
+	int64 Num = 0;
+	double MaxSeconds = 0.0;
+	int64 Counts[NumBuckets];
+};
+
+struct FMatchServerStats
+{
+	int32 ActiveMatches = 0;
+	int64 MatchesStarted = 0;
+	int64 MatchesFinished = 0;
+	int64 MovesPlayed = 0;
+	int64 MovesRejected = 0;
+	int64 Timeouts = 0;
+
+	// From SubmitMove to the move being checked and played by its shard
+	FLatencyHistogram MoveLatency;
+
+	// Time a shard takes for one Update, the slowest shard bounds the server's update rate
+	FLatencyHistogram ShardUpdateTime;
+};
+
+/**
+ * Hosts many matches in one process on the headless rules, without any actor or world per match.
+ * Matches are spread over shards by id, every Update runs each shard on a worker thread, and a shard
+ * is never touched by two threads at once, so matches need no locking of their own. Only the inbox
+ * of commands and the outbox of events of each shard are shared, each behind its own lock.
+ *
+ * CreateMatch, SubmitMove and PopEvents may be called from any thread, also while Update runs.
+ * Update itself is driven by one thread, as often as turn timers should be checked.
+ */
+class MICEMEN_API FMatchServer
+{
+public:
+	explicit FMatchServer(const FMatchServerSettings& InSettings = FMatchServerSettings());
+	~FMatchServer();
+
+	// Queue a new match, it starts on the next Update. Returns its id
+	int32 CreateMatch(int32 Seed, bool bFairBoard = false);
+
+	// Queue a move of Team, it is checked against the rules and the turn on the next Update
+	void SubmitMove(int32 Match, EBoardCell Team, FBoardMove Move);
+
+	// Run every shard once: take in commands, check turn timers and publish the events
+	void Update();
+
+	// Take every event published so far, shard by shard
+	void PopEvents(TArray<FMatchServerEvent>& OutEvents);
+
+	// Totals of every shard, call from the thread driving Update
+	FMatchServerStats GetStats() const;
+
+	int32 GetNumShards() const { return Shards.Num(); }
+
+private:
+	struct FCommand
+	{
+		int32 Match;
+		int32 Seed;
+		bool bCreate;
+		bool bFairBoard;
+		EBoardCell Team;
+		FBoardMove Move;
+		uint64 SubmitCycles;
+	};
+
+	struct FServerMatch
+	{
+		int32 Id;
+		FMatchState State;
+		int32 Plies;
+		double TurnDeadline;
+	};
+
+	struct FShard
+	{
+		FCriticalSection InboxLock;
+		TArray<FCommand> Inbox;
+
+		FCriticalSection OutboxLock;
+		TArray<FMatchServerEvent> Outbox;
+
+		// Only touched by the worker updating the shard
+		TArray<FCommand> Commands;
+		TArray<FMatchServerEvent> Events;
+		TArray<FServerMatch> Matches;
+
+		// Slot in Matches of every match of this shard by Id / NumShards, INDEX_NONE once it ended
+		TArray<int32> Slots;
+
+		FMatchServerStats Stats;
+	};
+
+	void UpdateShard(FShard& Shard, double Now);
+	void StartMatch(FShard& Shard, const FCommand& Command, double Now);
+	void PlayMove(FShard& Shard, const FCommand& Command, double Now);
+	void FinishMatch(FShard& Shard, int32 Slot, EMatchResult Result, EMatchEnd End);
+
+	FMatchServerSettings Settings;
+	TArray<TUniquePtr<FShard>> Shards;
+	TAtomic<int32> NextMatch;
+};
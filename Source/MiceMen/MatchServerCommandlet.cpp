@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MatchServerCommandlet.h"
+#include "MiceMen.h"
+#include "MatchServerLoad.h"
+#include "Misc/Parse.h"
+
+UMatchServerCommandlet::UMatchServerCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UMatchServerCommandlet::Main(const FString& Params)
+{
+	FMatchServerLoadSettings Settings;
+	FParse::Value(*Params, TEXT("matches="), Settings.ConcurrentMatches);
+	FParse::Value(*Params, TEXT("total="), Settings.TotalMatches);
+	FParse::Value(*Params, TEXT("seed="), Settings.Seed);
+	FParse::Value(*Params, TEXT("illegal="), Settings.IllegalPercent);
+	FParse::Value(*Params, TEXT("silent="), Settings.SilentPercent);
+	FParse::Value(*Params, TEXT("shards="), Settings.Server.NumShards);
+	FParse::Value(*Params, TEXT("turntime="), Settings.Server.TurnSeconds);
+	FParse::Value(*Params, TEXT("maxplies="), Settings.Server.MaxPlies);
+	Settings.Server.bSingleThreaded = FParse::Param(*Params, TEXT("singlethread"));
+	Settings.bFairBoards = FParse::Param(*Params, TEXT("fair"));
+
+	if (Settings.ConcurrentMatches <= 0 || Settings.TotalMatches <= 0 || Settings.Server.MaxPlies <= 0 || Settings.Server.TurnSeconds <= 0.0f)
+	{
+		UE_LOG(LogMiceMen, Error, TEXT("MatchServer: -matches, -total, -maxplies and -turntime must be positive"));
+		return 1;
+	}
+
+	UE_LOG(LogMiceMen, Display, TEXT("MatchServer: %d matches, %d at once, seed %d, %.1f%% illegal moves, %.1f%% silent clients%s"),
+		Settings.TotalMatches, Settings.ConcurrentMatches, Settings.Seed, Settings.IllegalPercent, Settings.SilentPercent,
+		Settings.bFairBoards ? TEXT(", fair boards") : TEXT(""));
+
+	const FMatchServerLoadStats Stats = FMatchServerLoad::Run(Settings);
+	const FMatchServerStats& Server = Stats.Server;
+
+	const double Percent = 100.0 / Server.MatchesFinished;
+	UE_LOG(LogMiceMen, Display, TEXT("Blue wins:  %d (%.1f%%)"), Stats.BlueWins, Stats.BlueWins * Percent);
+	UE_LOG(LogMiceMen, Display, TEXT("Red wins:   %d (%.1f%%)"), Stats.RedWins, Stats.RedWins * Percent);
+	UE_LOG(LogMiceMen, Display, TEXT("Draws:      %d (%.1f%%)"), Stats.Draws, Stats.Draws * Percent);
+	UE_LOG(LogMiceMen, Display, TEXT("Timeouts:   %lld, rejected moves: %lld"), Server.Timeouts, Server.MovesRejected);
+
+	UE_LOG(LogMiceMen, Display, TEXT("Move latency: 50%% %.0f us, 90%% %.0f us, 99%% %.0f us, 99.9%% %.0f us, max %.0f us"),
+		Server.MoveLatency.GetPercentile(0.5) * 1000000.0, Server.MoveLatency.GetPercentile(0.9) * 1000000.0,
+		Server.MoveLatency.GetPercentile(0.99) * 1000000.0, Server.MoveLatency.GetPercentile(0.999) * 1000000.0,
+		Server.MoveLatency.MaxSeconds * 1000000.0);
+	UE_LOG(LogMiceMen, Display, TEXT("Shard update: 50%% %.0f us, 99%% %.0f us, max %.0f us over %lld updates"),
+		Server.ShardUpdateTime.GetPercentile(0.5) * 1000000.0, Server.ShardUpdateTime.GetPercentile(0.99) * 1000000.0,
+		Server.ShardUpdateTime.MaxSeconds * 1000000.0, Stats.Updates);
+
+	UE_LOG(LogMiceMen, Display, TEXT("%.2f seconds, %.1f matches per second, %.0f moves per second"), Stats.Seconds, Stats.MatchesPerSecond, Stats.MovesPerSecond);
+
+	if (Stats.Mismatches > 0)
+	{
+		UE_LOG(LogMiceMen, Error, TEXT("MatchServer: %d events disagreed with the clients' rules"), Stats.Mismatches);
+		return 1;
+	}
+	return 0;
+}
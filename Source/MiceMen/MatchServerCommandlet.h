@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MatchServerCommandlet.generated.h"
+
+/**
+ * Hosts many headless matches on an FMatchServer against simulated clients and logs throughput and latency. Run with
+ * UE4Editor-Cmd MiceMen.uproject -run=MatchServer -matches=4000 -total=100000 -illegal=1 -silent=0.5 -turntime=2
+ * Options: -matches= -total= -shards= -seed= -turntime= -maxplies= -illegal= -silent= -fair -singlethread
+ */
+UCLASS()
+class MICEMEN_API UMatchServerCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMatchServerCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
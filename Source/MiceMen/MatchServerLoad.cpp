@@ -0,0 +1,151 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MatchServerLoad.h"
+#include "BoardGenerator.h"
+#include "HAL/PlatformTime.h"
+
+namespace
+{
+	struct FLoadClient
+	{
+		FMatchState State;
+		FRandomStream Random;
+		bool bSilent = false;
+
+		// A deliberately bad move was sent, the next event must be its rejection
+		bool bExpectRejection = false;
+
+		// Moves sent before the Finished event came in are refused as NotPlaying
+		bool bFinished = false;
+	};
+
+	int32 StartClient(FMatchServer& Server, const FMatchServerLoadSettings& Settings, int32 Index, TArray<FLoadClient>& Clients)
+	{
+		const int32 Seed = int32(HashCombine(uint32(Settings.Seed), uint32(Index)));
+		const int32 Match = Server.CreateMatch(Seed, Settings.bFairBoards);
+		if (Clients.Num() <= Match)
+		{
+			Clients.SetNum(Match + 1);
+		}
+
+		// The client knows the seed, so it sets up the same board the server does
+		FLoadClient& Client = Clients[Match];
+		if (Settings.bFairBoards)
+		{
+			FBoardGenerator().Generate(Seed, Client.State);
+		}
+		else
+		{
+			Client.State.Generate(FRandomStream(Seed));
+		}
+		Client.Random.Initialize(Seed);
+		Client.bSilent = Client.Random.GetFraction() * 100.0f < Settings.SilentPercent;
+		Client.bExpectRejection = false;
+		Client.bFinished = false;
+		return Match;
+	}
+
+	void PlayTurn(FMatchServer& Server, const FMatchServerLoadSettings& Settings, int32 Match, FLoadClient& Client)
+	{
+		if (Client.bSilent || Client.State.IsFinished())
+		{
+			return;
+		}
+
+		const EBoardCell Team = Client.State.SideToMove;
+		if (!Client.bExpectRejection && Client.Random.GetFraction() * 100.0f < Settings.IllegalPercent)
+		{
+			// Either the wrong team moves or the column breaks the rules, the real move follows the rejection
+			const FBoardMove Move(Client.Random.RandRange(0, FBoardState::Width - 1), Client.Random.GetFraction() < 0.5f);
+			const EBoardCell OtherTeam = Team == EBoardCell::Blue ? EBoardCell::Red : EBoardCell::Blue;
+			if (!Client.State.IsLegalMove(Move) || Client.Random.GetFraction() < 0.5f)
+			{
+				Client.bExpectRejection = true;
+				Server.SubmitMove(Match, Client.State.IsLegalMove(Move) ? OtherTeam : Team, Move);
+				return;
+			}
+		}
+
+		FBoardMove Moves[FMatchState::MaxMoves];
+		const int32 NumMoves = Client.State.GetLegalMoves(Moves);
+		if (NumMoves > 0)
+		{
+			Server.SubmitMove(Match, Team, Moves[Client.Random.RandRange(0, NumMoves - 1)]);
+		}
+	}
+}
+
+FMatchServerLoadStats FMatchServerLoad::Run(const FMatchServerLoadSettings& Settings)
+{
+	FMatchServerLoadStats Stats;
+	FMatchServer Server(Settings.Server);
+	TArray<FLoadClient> Clients;
+	Clients.Reserve(Settings.TotalMatches);
+
+	const double StartTime = FPlatformTime::Seconds();
+	int32 Created = 0;
+	int32 Finished = 0;
+	while (Created < FMath::Min(Settings.ConcurrentMatches, Settings.TotalMatches))
+	{
+		StartClient(Server, Settings, Created++, Clients);
+	}
+
+	TArray<FMatchServerEvent> Events;
+	while (Finished < Settings.TotalMatches)
+	{
+		Server.Update();
+		++Stats.Updates;
+
+		Events.Reset();
+		Server.PopEvents(Events);
+		for (const FMatchServerEvent& Event : Events)
+		{
+			FLoadClient& Client = Clients[Event.Match];
+			switch (Event.Type)
+			{
+			case EMatchServerEvent::Started:
+				Stats.Mismatches += Event.Team != Client.State.SideToMove;
+				PlayTurn(Server, Settings, Event.Match, Client);
+				break;
+
+			case EMatchServerEvent::Moved:
+				Stats.Mismatches += Client.bExpectRejection || !Client.State.IsLegalMove(Event.Move);
+				Client.State.ApplyMove(Event.Move);
+				PlayTurn(Server, Settings, Event.Match, Client);
+				break;
+
+			case EMatchServerEvent::Rejected:
+				if (Client.bFinished)
+				{
+					Stats.Mismatches += Event.Rejection != EMatchRejection::NotPlaying;
+					break;
+				}
+				Stats.Mismatches += !Client.bExpectRejection;
+				Client.bExpectRejection = false;
+				PlayTurn(Server, Settings, Event.Match, Client);
+				break;
+
+			case EMatchServerEvent::Finished:
+				Stats.Mismatches += Event.End == EMatchEnd::Played && (Event.Result != Client.State.GetResult()
+					|| Event.BlueScore != Client.State.Board.BlueScore || Event.RedScore != Client.State.Board.RedScore);
+				Stats.BlueWins += Event.Result == EMatchResult::BlueWins;
+				Stats.RedWins += Event.Result == EMatchResult::RedWins;
+				Stats.Draws += Event.Result == EMatchResult::Draw;
+				Client.bFinished = true;
+				++Finished;
+				if (Created < Settings.TotalMatches)
+				{
+					StartClient(Server, Settings, Created++, Clients);
+				}
+				break;
+			}
+		}
+	}
+
+	Stats.Server = Server.GetStats();
+	Stats.Seconds = FPlatformTime::Seconds() - StartTime;
+	Stats.MatchesPerSecond = Stats.Seconds > 0.0 ? Finished / Stats.Seconds : 0.0;
+	Stats.MovesPerSecond = Stats.Seconds > 0.0 ? Stats.Server.MovesPlayed / Stats.Seconds : 0.0;
+	return Stats;
+}
@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MatchServer.h"
+
+struct FMatchServerLoadSettings
+{
+	FMatchServerSettings Server;
+
+	// Matches kept running at once, a new one is created whenever one ends
+	int32 ConcurrentMatches = 1000;
+	int32 TotalMatches = 10000;
+
+	// Match N is played on a board from Seed and N only
+	int32 Seed = 0;
+
+	// Chance of a client sending a move that must be rejected before its real one
+	float IllegalPercent = 1.0f;
+
+	// Chance of a client never answering in a match, so it loses on time
+	float SilentPercent = 0.0f;
+
+	bool bFairBoards = false;
+};
+
+struct FMatchServerLoadStats
+{
+	FMatchServerStats Server;
+
+	int32 BlueWins = 0;
+	int32 RedWins = 0;
+	int32 Draws = 0;
+
+	// Events the clients' own copy of the rules disagreed with, zero unless the server is broken
+	int32 Mismatches = 0;
+
+	int64 Updates = 0;
+	double Seconds = 0.0;
+	double MatchesPerSecond = 0.0;
+	double MovesPerSecond = 0.0;
+};
+
+/**
+ * Drives an FMatchServer with simulated clients in the same process. Every client follows its match
+ * on its own FMatchState from the events alone and answers each turn at once with a random legal move,
+ * so the server's throughput and latency are measured without any network in the way.
+ */
+class MICEMEN_API FMatchServerLoad
+{
+public:
+	static FMatchServerLoadStats Run(const FMatchServerLoadSettings& Settings);
+};
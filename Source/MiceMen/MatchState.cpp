@@ -0,0 +1,240 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MatchState.h"
+#include "Zobrist.h"
+
+constexpr int32 FMatchState::MoveHistoryLength;
+constexpr int32 FMatchState::DrawCountdownTurns;
+constexpr int32 FMatchState::MaxMoves;
+
+FMatchState::FMatchState()
+	: SideToMove(EBoardCell::Blue)
+	, TurnsBeforeDraw(DrawCountdownTurns)
+	, bDrawCountdownBegan(false)
+{
+	FMemory::Memzero(PreviousMoves);
+	FMemory::Memzero(NumPreviousMoves);
+	UpdateHash();
+}
+
+void FMatchState::Generate(const FRandomStream& Random)
+{
+	*this = FMatchState();
+	SideToMove = EBoardCell(Random.RandRange(1, 2));
+	Board.GenerateCheese(Random);
+	Board.GenerateMice(Random);
+	Board.Settle();
+	UpdateHash();
+}
+
+int32 FMatchState::GetLastMove(EBoardCell Team) const
+{
+	const int32 Index = TeamIndex(Team);
+	return NumPreviousMoves[Index] > 0 ? PreviousMoves[Index][NumPreviousMoves[Index] - 1] : INDEX_NONE;
+}
+
+int32 FMatchState::CountPreviousMoves(EBoardCell Team, int32 Column) const
+{
+	const int32 Index = TeamIndex(Team);
+	int32 NumberOfEqualMoves = 0;
+	for (int32 i = 0; i < NumPreviousMoves[Index]; ++i)
+	{
+		if (PreviousMoves[Index][i] == Column)
+		{
+			NumberOfEqualMoves++;
+		}
+	}
+	return NumberOfEqualMoves;
+}
+
+uint32 FMatchState::GetLegalColumns() const
+{
+	uint32 Columns = Board.GetTeamColumns(SideToMove);
+
+	// If the other team has moved at least once and my mice are in more than one column
+	const int32 OpponentLastMove = GetLastMove(Opponent(SideToMove));
+	if (OpponentLastMove != INDEX_NONE && FMath::CountBits(Columns) > 1)
+	{
+		// The column moved in the other player's last move can't be moved back right away
+		uint32 Filtered = Columns & ~(1u << OpponentLastMove);
+		for (uint32 Remaining = Filtered; Remaining != 0; Remaining &= Remaining - 1)
+		{
+			// Neither can a column I moved on each of my last turns
+			const int32 Column = FMath::CountTrailingZeros(Remaining);
+			if (CountPreviousMoves(SideToMove, Column) == MoveHistoryLength)
+			{
+				Filtered &= ~(1u << Column);
+			}
+		}
+
+		// Never leave a team without any column to move
+		if (Filtered != 0)
+		{
+			Columns = Filtered;
+		}
+	}
+	return Columns;
+}
+
+int32 FMatchState::GetLegalMoves(FBoardMove* OutMoves) const
+{
+	int32 NumMoves = 0;
+	for (uint32 Columns = GetLegalColumns(); Columns != 0; Columns &= Columns - 1)
+	{
+		const int32 Column = FMath::CountTrailingZeros(Columns);
+		OutMoves[NumMoves++] = FBoardMove(Column, true);
+		OutMoves[NumMoves++] = FBoardMove(Column, false);
+	}
+	return NumMoves;
+}
+
+bool FMatchState::IsLegalMove(FBoardMove Move) const
+{
+	return Move.Column >= 0 && Move.Column < FBoardState::Width && (GetLegalColumns() & (1u << Move.Column)) != 0;
+}
+
+void FMatchState::ApplyMove(FBoardMove Move, TArray<FBoardStep>* OutSteps)
+{
+	const int32 Index = BeginMove(Move);
+	Board.MoveColumn(Move.Column, Move.bUpward);
+	if (OutSteps != nullptr)
+	{
+		Board.Settle(*OutSteps, FBoardState::GetNeighbourColumns(Move.Column));
+	}
+	else
+	{
+		Board.Settle(FBoardState::GetNeighbourColumns(Move.Column));
+	}
+	EndMove(Index);
+}
+
+void FMatchState::ApplyMove(FBoardMove Move, FMoveDelta& OutDelta, TArray<FBoardStep>& OutSteps)
+{
+	const int32 Index = TeamIndex(SideToMove);
+	OutDelta.Move = Move;
+	OutDelta.DroppedMove = NumPreviousMoves[Index] == MoveHistoryLength ? PreviousMoves[Index][0] : int8(INDEX_NONE);
+	OutDelta.TurnsBeforeDraw = int8(TurnsBeforeDraw);
+	OutDelta.bDrawCountdownBegan = bDrawCountdownBegan;
+	OutDelta.StateHash = StateHash;
+	OutDelta.FirstStep = OutSteps.Num();
+	ApplyMove(Move, &OutSteps);
+	OutDelta.NumSteps = OutSteps.Num() - OutDelta.FirstStep;
+}
+
+void FMatchState::UndoMove(const FMoveDelta& Delta, const TArray<FBoardStep>& Steps)
+{
+	SideToMove = Opponent(SideToMove);
+	for (int32 i = Delta.FirstStep + Delta.NumSteps - 1; i >= Delta.FirstStep; --i)
+	{
+		Board.UndoStep(Steps[i]);
+	}
+	Board.MoveColumn(Delta.Move.Column, !Delta.Move.bUpward);
+
+	// Drop the move from the history and bring back the one it pushed out
+	const int32 Index = TeamIndex(SideToMove);
+	NumPreviousMoves[Index]--;
+	if (Delta.DroppedMove != INDEX_NONE)
+	{
+		FMemory::Memmove(&PreviousMoves[Index][1], &PreviousMoves[Index][0], MoveHistoryLength - 1);
+		PreviousMoves[Index][0] = Delta.DroppedMove;
+		NumPreviousMoves[Index]++;
+	}
+
+	TurnsBeforeDraw = Delta.TurnsBeforeDraw;
+	bDrawCountdownBegan = Delta.bDrawCountdownBegan;
+	StateHash = Delta.StateHash;
+}
+
+void FMatchState::RedoMove(const FMoveDelta& Delta, const TArray<FBoardStep>& Steps)
+{
+	const int32 Index = BeginMove(Delta.Move);
+	Board.MoveColumn(Delta.Move.Column, Delta.Move.bUpward);
+	for (int32 i = Delta.FirstStep; i < Delta.FirstStep + Delta.NumSteps; ++i)
+	{
+		Board.ApplyStep(Steps[i]);
+	}
+	EndMove(Index);
+}
+
+int32 FMatchState::BeginMove(FBoardMove Move)
+{
+	// Perform operations on current team's array of previous moves
+	const int32 Index = TeamIndex(SideToMove);
+	StateHash ^= HashPreviousMoves(Index) ^ HashDrawCountdown();
+	if (NumPreviousMoves[Index] == MoveHistoryLength)
+	{
+		FMemory::Memmove(&PreviousMoves[Index][0], &PreviousMoves[Index][1], MoveHistoryLength - 1);
+		NumPreviousMoves[Index]--;
+	}
+	PreviousMoves[Index][NumPreviousMoves[Index]++] = int8(Move.Column);
+
+	if (bDrawCountdownBegan)
+	{
+		TurnsBeforeDraw--;
+	}
+	return Index;
+}
+
+void FMatchState::EndMove(int32 Index)
+{
+	if (Board.BlueScore == FBoardState::MicePerTeam - 1 && Board.RedScore == FBoardState::MicePerTeam - 1)
+	{
+		bDrawCountdownBegan = true;
+	}
+	SideToMove = Opponent(SideToMove);
+	StateHash ^= HashPreviousMoves(Index) ^ HashDrawCountdown() ^ FZobristKeys::Get().RedToMove;
+}
+
+EMatchResult FMatchState::GetResult() const
+{
+	const bool bBlueDone = Board.BlueScore >= FBoardState::MicePerTeam;
+	const bool bRedDone = Board.RedScore >= FBoardState::MicePerTeam;
+	if (bBlueDone && bRedDone)
+	{
+		return EMatchResult::Draw;
+	}
+	if (bBlueDone)
+	{
+		return EMatchResult::BlueWins;
+	}
+	if (bRedDone)
+	{
+		return EMatchResult::RedWins;
+	}
+	if (bDrawCountdownBegan && TurnsBeforeDraw <= 0)
+	{
+		return EMatchResult::Draw;
+	}
+	return EMatchResult::Playing;
+}
+
+void FMatchState::UpdateHash()
+{
+	Board.Hash = Board.ComputeHash();
+	StateHash = HashPreviousMoves(0) ^ HashPreviousMoves(1) ^ HashDrawCountdown();
+	if (SideToMove == EBoardCell::Red)
+	{
+		StateHash ^= FZobristKeys::Get().RedToMove;
+	}
+}
+
+uint64 FMatchState::HashPreviousMoves(int32 Index) const
+{
+	const FZobristKeys& Keys = FZobristKeys::Get();
+	uint64 MovesHash = 0;
+	for (int32 i = 0; i < NumPreviousMoves[Index]; ++i)
+	{
+		MovesHash ^= Keys.PreviousMoves[Index][i][PreviousMoves[Index][i]];
+	}
+	return MovesHash;
+}
+
+uint64 FMatchState::HashDrawCountdown() const
+{
+	if (!bDrawCountdownBegan)
+	{
+		return 0;
+	}
+	return FZobristKeys::Get().TurnsBeforeDraw[FMath::Clamp(TurnsBeforeDraw, 0, DrawCountdownTurns)];
+}
@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BoardState.h"
+
+// A turn: one column moved one cell up or down
+struct FBoardMove
+{
+	int32 Column = INDEX_NONE;
+	bool bUpward = false;
+
+	FBoardMove() {}
+	FBoardMove(int32 InColumn, bool bInUpward) : Column(InColumn), bUpward(bInUpward) {}
+
+	bool IsValid() const { return Column != INDEX_NONE; }
+	bool operator==(const FBoardMove& Other) const { return Column == Other.Column && bUpward == Other.bUpward; }
+
+	// Column in the upper bits, direction in bit 0
+	uint8 Encode() const { return uint8((Column << 1) | (bUpward ? 1 : 0)); }
+	static FBoardMove Decode(uint8 Byte) { return FBoardMove(Byte >> 1, (Byte & 1) != 0); }
+};
+
+// What a move changed besides its settle steps, enough to take it back or play it again without settling
+struct FMoveDelta
+{
+	FBoardMove Move;
+
+	// Column that dropped out of the mover's full history, INDEX_NONE if there was room left
+	int8 DroppedMove = INDEX_NONE;
+
+	// Draw countdown and state hash from before the move
+	int8 TurnsBeforeDraw = 0;
+	bool bDrawCountdownBegan = false;
+	uint64 StateHash = 0;
+
+	// Settle steps of the move, FirstStep indexes the step array the move was recorded into
+	int32 FirstStep = 0;
+	int32 NumSteps = 0;
+};
+
+enum class EMatchResult : uint8
+{
+	Playing,
+	BlueWins,
+	RedWins,
+	Draw
+};
+
+/**
+ * Everything needed to play a match without actors: the board, whose turn it is, the recent
+ * moves of both teams and the draw countdown, following the rules of AControllerPawn.
+ */
+struct MICEMEN_API FMatchState
+{
+	// Number of previous moves remembered per team, a column moved in all of them can't be moved again
+	static constexpr int32 MoveHistoryLength = 6;
+	// Moves left once both teams are one mouse away from winning
+	static constexpr int32 DrawCountdownTurns = 8;
+	static constexpr int32 MaxMoves = FBoardState::Width * 2;
+
+	FMatchState();
+
+	// Set up a new match from a stream: pick the first team, place cheese and mice, then settle.
+	// AGrid draws from its stream in the same order, so a seed gives the same match in both.
+	void Generate(const FRandomStream& Random);
+
+	FBoardState Board;
+	EBoardCell SideToMove;
+
+	// Columns moved by each team, oldest first
+	int8 PreviousMoves[2][MoveHistoryLength];
+	int32 NumPreviousMoves[2];
+
+	int32 TurnsBeforeDraw;
+	bool bDrawCountdownBegan;
+
+	static int32 TeamIndex(EBoardCell Team) { return Team == EBoardCell::Blue ? 0 : 1; }
+	static EBoardCell Opponent(EBoardCell Team) { return Team == EBoardCell::Blue ? EBoardCell::Red : EBoardCell::Blue; }
+
+	int32 GetLastMove(EBoardCell Team) const;
+	int32 CountPreviousMoves(EBoardCell Team, int32 Column) const;
+
+	// Columns the side to move may pick, bit X is set for column X
+	uint32 GetLegalColumns() const;
+
+	// Fill OutMoves (at least MaxMoves long) with every legal move, returns how many were written
+	int32 GetLegalMoves(FBoardMove* OutMoves) const;
+	bool IsLegalMove(FBoardMove Move) const;
+
+	// Play a move, settle the board and pass the turn. Settle steps are appended to OutSteps if given
+	void ApplyMove(FBoardMove Move, TArray<FBoardStep>* OutSteps = nullptr);
+
+	// Same as above, also recording what changed so UndoMove can take the move back. Steps are appended to OutSteps
+	void ApplyMove(FBoardMove Move, FMoveDelta& OutDelta, TArray<FBoardStep>& OutSteps);
+
+	// Take back the last move played, reverting its steps in reverse order. Costs as much as the move changed
+	void UndoMove(const FMoveDelta& Delta, const TArray<FBoardStep>& Steps);
+
+	// Play a move taken back by UndoMove again from its recorded steps, without settling
+	void RedoMove(const FMoveDelta& Delta, const TArray<FBoardStep>& Steps);
+
+	EMatchResult GetResult() const;
+	bool IsFinished() const { return GetResult() != EMatchResult::Playing; }
+
+	// Zobrist hash of everything that affects the rest of the match: pieces, scores, side to move, move history and draw countdown
+	uint64 GetHash() const { return Board.Hash ^ StateHash; }
+
+	// Recompute the hash after editing the state directly instead of through ApplyMove
+	void UpdateHash();
+
+	// Hash of the side to move, move history and draw countdown, kept up to date by ApplyMove
+	uint64 StateHash;
+
+private:
+	// Move history and draw countdown changes made before the board moves, returns the mover's team index
+	int32 BeginMove(FBoardMove Move);
+	// Draw countdown check and turn change once the board settled
+	void EndMove(int32 Index);
+
+	uint64 HashPreviousMoves(int32 Index) const;
+	uint64 HashDrawCountdown() const;
+};
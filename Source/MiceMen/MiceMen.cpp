@@ -4,3 +4,7 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, MiceMen, "MiceMen" );
+
+DEFINE_LOG_CATEGORY(LogMiceMen);
+
+CSV_DEFINE_CATEGORY(MiceMen, true);
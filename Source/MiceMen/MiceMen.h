@@ -3,4 +3,13 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogMiceMen, Log, All);
+
+// Shown with "stat MiceMen"
+DECLARE_STATS_GROUP(TEXT("MiceMen"), STATGROUP_MiceMen, STATCAT_Advanced);
+
+// Per frame samples written by "CsvProfile Start", or -csvCaptureFrames=N for headless runs
+CSV_DECLARE_CATEGORY_EXTERN(MiceMen);
@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MoveAnalysis.h"
+#include "TranspositionTable.h"
+#include "Async/ParallelFor.h"
+#include "Templates/Atomic.h"
+#include "HAL/PlatformTime.h"
+
+static FORCEINLINE bool IsForcedScore(int32 Score)
+{
+	return FMath::Abs(Score) >= FBoardSearch::WinScore - FBoardSearch::MaxDepth;
+}
+
+// Best first, stable so equal scores keep the move order and rankings are reproducible
+static void SortEvaluations(TArray<FMoveEvaluation>& Moves)
+{
+	Moves.StableSort([](const FMoveEvaluation& A, const FMoveEvaluation& B)
+	{
+		return A.Score > B.Score;
+	});
+}
+
+FMoveAnalysisResult FMoveAnalysis::Analyze(const FMatchState& Root, double LatencySeconds, FTranspositionTable* Table, int32 DepthLimit, bool bSingleThreaded)
+{
+	FMoveAnalysisSettings Settings;
+	Settings.LatencySeconds = LatencySeconds;
+	Settings.Table = Table;
+	Settings.DepthLimit = DepthLimit;
+	Settings.bSingleThreaded = bSingleThreaded;
+	return Analyze(Root, Settings);
+}
+
+FMoveAnalysisResult FMoveAnalysis::Analyze(const FMatchState& Root, const FMoveAnalysisSettings& Settings)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	const double Deadline = StartTime + Settings.LatencySeconds;
+	FTranspositionTable* Table = Settings.Table;
+	const TAtomic<bool>* CancelFlag = Settings.CancelFlag;
+	FMoveAnalysisResult Result;
+	if (Root.IsFinished())
+	{
+		return Result;
+	}
+
+	FBoardMove Moves[FMatchState::MaxMoves];
+	FMatchState Children[FMatchState::MaxMoves];
+	const int32 NumMoves = Root.GetLegalMoves(Moves);
+	for (int32 i = 0; i < NumMoves; ++i)
+	{
+		Children[i] = Root;
+		Children[i].ApplyMove(Moves[i]);
+	}
+	if (Table != nullptr)
+	{
+		Table->NewSearch();
+	}
+
+	// Deepen every move together so their scores stay comparable, only iterations every move completed are kept
+	TArray<FMoveEvaluation> Iteration;
+	Iteration.SetNum(NumMoves);
+	for (int32 Depth = 1; Depth <= FMath::Min(Settings.DepthLimit, FBoardSearch::MaxDepth); ++Depth)
+	{
+		TAtomic<int32> NumCompleted(0);
+		ParallelFor(NumMoves, [&Moves, &Children, &Iteration, &NumCompleted, Table, CancelFlag, Deadline, Depth](int32 Index)
+		{
+			FBoardSearch Search(Table, false);
+			Search.SetCancelFlag(CancelFlag);
+			const FBoardSearchResult ChildResult = Search.Search(Children[Index], FMath::Max(Deadline - FPlatformTime::Seconds(), 0.0), Depth - 1);
+
+			FMoveEvaluation& Evaluation = Iteration[Index];
+			Evaluation.Move = Moves[Index];
+			Evaluation.Score = -ChildResult.Score;
+			Evaluation.Nodes += ChildResult.Nodes + 1;
+
+			// Forced results are one move further away from the root than from the child
+			if (IsForcedScore(Evaluation.Score))
+			{
+				Evaluation.Score += Evaluation.Score > 0 ? -1 : 1;
+			}
+			if (ChildResult.Depth >= Depth - 1 || Children[Index].IsFinished() || IsForcedScore(Evaluation.Score))
+			{
+				++NumCompleted;
+			}
+		}, Settings.bSingleThreaded);
+
+		if (NumCompleted.Load() < NumMoves || (CancelFlag != nullptr && CancelFlag->Load()))
+		{
+			break;
+		}
+		Result.Moves = Iteration;
+		Result.Depth = Depth;
+		SortEvaluations(Result.Moves);
+		if (Settings.OnIteration)
+		{
+			Result.Nodes = 0;
+			for (const FMoveEvaluation& Evaluation : Iteration)
+			{
+				Result.Nodes += Evaluation.Nodes;
+			}
+			Result.Seconds = FPlatformTime::Seconds() - StartTime;
+			Settings.OnIteration(Result);
+		}
+
+		// Stop once every outcome is forced or the next iteration would not finish in time
+		bool bAllForced = true;
+		for (const FMoveEvaluation& Evaluation : Iteration)
+		{
+			bAllForced = bAllForced && IsForcedScore(Evaluation.Score);
+		}
+		if (bAllForced || FPlatformTime::Seconds() - StartTime >= Settings.LatencySeconds * 0.5)
+		{
+			break;
+		}
+	}
+
+	Result.Nodes = 0;
+	for (const FMoveEvaluation& Evaluation : Iteration)
+	{
+		Result.Nodes += Evaluation.Nodes;
+	}
+	Result.Seconds = FPlatformTime::Seconds() - StartTime;
+	return Result;
+}
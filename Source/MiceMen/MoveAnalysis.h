@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BoardSearch.h"
+
+class FTranspositionTable;
+
+struct FMoveEvaluation
+{
+	FBoardMove Move;
+
+	// Score after the move from the point of view of the side that played it
+	int32 Score = 0;
+
+	// Nodes searched below the move over every iteration
+	int64 Nodes = 0;
+};
+
+struct FMoveAnalysisResult
+{
+	// Every legal move, best first
+	TArray<FMoveEvaluation> Moves;
+
+	// Deepest iteration every move completed, counting the move itself
+	int32 Depth = 0;
+	int64 Nodes = 0;
+	double Seconds = 0.0;
+
+	// Best move, invalid if there was no legal move
+	FBoardMove GetBestMove() const { return Moves.Num() > 0 ? Moves[0].Move : FBoardMove(); }
+};
+
+// How long and how deep an analysis runs, and how another thread can follow or stop it
+struct FMoveAnalysisSettings
+{
+	double LatencySeconds = 1.0;
+
+	// Shared by every worker, may be null
+	FTranspositionTable* Table = nullptr;
+
+	int32 DepthLimit = FBoardSearch::MaxDepth;
+	bool bSingleThreaded = false;
+
+	// Set from any thread to stop the analysis, the last iteration every move completed is kept. It must outlive the analysis
+	const TAtomic<bool>* CancelFlag = nullptr;
+
+	// Called on the analysing thread after every iteration every move completed, with the ranking so far
+	TFunction<void(const FMoveAnalysisResult&)> OnIteration;
+};
+
+/**
+ * Scores every legal move of a position at once. Each move is played on its own copy of the
+ * position and searched by its own FBoardSearch on a worker thread. All moves are deepened
+ * together and only iterations every move completed before the deadline are kept, so scores
+ * stay comparable and the ranking is ready within the latency target. Used for computer moves and hints.
+ */
+class MICEMEN_API FMoveAnalysis
+{
+public:
+	// Rank the moves of Root within LatencySeconds. The table, if any, is shared by every worker
+	static FMoveAnalysisResult Analyze(const FMatchState& Root, double LatencySeconds, FTranspositionTable* Table = nullptr,
+		int32 DepthLimit = FBoardSearch::MaxDepth, bool bSingleThreaded = false);
+
+	static FMoveAnalysisResult Analyze(const FMatchState& Root, const FMoveAnalysisSettings& Settings);
+};
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MoveLog.h"
+
+void FMoveLog::Reset()
+{
+	Deltas.Reset();
+	Steps.Reset();
+	NumApplied = 0;
+}
+
+void FMoveLog::Apply(FMatchState& State, FBoardMove Move)
+{
+	// A new move replaces whatever could have been redone
+	if (CanRedo())
+	{
+		Steps.SetNum(Deltas[NumApplied].FirstStep, false);
+		Deltas.SetNum(NumApplied, false);
+	}
+
+	const int32 Index = Deltas.AddDefaulted();
+	State.ApplyMove(Move, Deltas[Index], Steps);
+	NumApplied++;
+}
+
+bool FMoveLog::Undo(FMatchState& State)
+{
+	if (!CanUndo())
+	{
+		return false;
+	}
+	NumApplied--;
+	State.UndoMove(Deltas[NumApplied], Steps);
+	return true;
+}
+
+bool FMoveLog::Redo(FMatchState& State)
+{
+	if (!CanRedo())
+	{
+		return false;
+	}
+	State.RedoMove(Deltas[NumApplied], Steps);
+	NumApplied++;
+	return true;
+}
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MatchState.h"
+
+/**
+ * Undo and redo history of a match. Every move is kept as a FMoveDelta plus its settle steps,
+ * stored one after the other in a single array, so taking a move back or playing it again only
+ * touches what the move changed and never copies the board.
+ */
+class MICEMEN_API FMoveLog
+{
+public:
+	void Reset();
+
+	// Play a move on State and record it, any move undone before is forgotten
+	void Apply(FMatchState& State, FBoardMove Move);
+
+	// Take back the last move played on State, returns false if there is none
+	bool Undo(FMatchState& State);
+
+	// Play the last move taken back again, returns false if there is none
+	bool Redo(FMatchState& State);
+
+	bool CanUndo() const { return NumApplied > 0; }
+	bool CanRedo() const { return NumApplied < Deltas.Num(); }
+
+	// Number of moves currently played, moves past it can be redone
+	int32 Num() const { return NumApplied; }
+
+	// Move Undo would take back and Redo would play next
+	const FMoveDelta& GetUndoDelta() const { return Deltas[NumApplied - 1]; }
+	const FMoveDelta& GetRedoDelta() const { return Deltas[NumApplied]; }
+
+	// Settle steps of every recorded move, indexed by FMoveDelta::FirstStep
+	const TArray<FBoardStep>& GetSteps() const { return Steps; }
+
+private:
+	TArray<FMoveDelta> Deltas;
+	TArray<FBoardStep> Steps;
+	int32 NumApplied = 0;
+};
@@ -0,0 +1,132 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SelfPlay.h"
+#include "BoardSearch.h"
+#include "BoardGenerator.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+
+constexpr int32 FSelfPlayStats::HistogramBucketPlies;
+
+FSelfPlayGame FSelfPlay::PlayGame(const FSelfPlaySettings& Settings, int32 GameIndex)
+{
+	FSelfPlayGame Game;
+	Game.Seed = int32(HashCombine(uint32(Settings.Seed), uint32(GameIndex)));
+
+	// Same setup as a level started with that seed
+	const FRandomStream Random(Game.Seed);
+	FMatchState State;
+	if (Settings.bFairBoards)
+	{
+		FBoardGenerator().Generate(Game.Seed, State);
+	}
+	else
+	{
+		State.Generate(Random);
+	}
+
+	FBoardMove Moves[FMatchState::MaxMoves];
+	while (!State.IsFinished() && Game.Plies < Settings.MaxPlies)
+	{
+		const FSelfPlayPlayer& Player = State.SideToMove == EBoardCell::Blue ? Settings.Blue : Settings.Red;
+		FBoardMove Move;
+		if (Player.SearchDepth > 0)
+		{
+			FBoardSearch Search;
+			Move = Search.Search(State, Player.ThinkTime, Player.SearchDepth).BestMove;
+		}
+		else
+		{
+			const int32 NumMoves = State.GetLegalMoves(Moves);
+			if (NumMoves > 0)
+			{
+				Move = Moves[Random.RandRange(0, NumMoves - 1)];
+			}
+		}
+		if (!Move.IsValid())
+		{
+			break;
+		}
+
+		State.ApplyMove(Move);
+		++Game.Plies;
+	}
+
+	Game.Result = State.GetResult();
+	Game.BlueScore = State.Board.BlueScore;
+	Game.RedScore = State.Board.RedScore;
+	return Game;
+}
+
+FSelfPlayStats FSelfPlay::Run(const FSelfPlaySettings& Settings, TArray<FSelfPlayGame>* OutGames)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Every game writes its own slot, so workers share nothing while playing
+	TArray<FSelfPlayGame> Games;
+	Games.SetNum(FMath::Max(Settings.NumGames, 0));
+	ParallelFor(Games.Num(), [&Settings, &Games](int32 GameIndex)
+	{
+		Games[GameIndex] = PlayGame(Settings, GameIndex);
+	}, Settings.bSingleThreaded);
+
+	FSelfPlayStats Stats;
+	Stats.Accumulate(Games);
+	Stats.Seconds = FPlatformTime::Seconds() - StartTime;
+	Stats.GamesPerSecond = Stats.Seconds > 0.0 ? Stats.NumGames / Stats.Seconds : 0.0;
+
+	if (OutGames != nullptr)
+	{
+		*OutGames = MoveTemp(Games);
+	}
+	return Stats;
+}
+
+void FSelfPlayStats::Accumulate(const TArray<FSelfPlayGame>& Games)
+{
+	NumGames = Games.Num();
+	if (NumGames == 0)
+	{
+		return;
+	}
+
+	TArray<int32> Lengths;
+	Lengths.Reserve(NumGames);
+	int64 TotalPlies = 0;
+	for (const FSelfPlayGame& Game : Games)
+	{
+		switch (Game.Result)
+		{
+		case EMatchResult::BlueWins:
+			BlueWins++;
+			break;
+		case EMatchResult::RedWins:
+			RedWins++;
+			break;
+		case EMatchResult::Draw:
+			Draws++;
+			break;
+		default:
+			Unfinished++;
+			break;
+		}
+
+		Lengths.Add(Game.Plies);
+		TotalPlies += Game.Plies;
+
+		const int32 Bucket = Game.Plies / HistogramBucketPlies;
+		if (Bucket >= PliesHistogram.Num())
+		{
+			PliesHistogram.AddZeroed(Bucket + 1 - PliesHistogram.Num());
+		}
+		PliesHistogram[Bucket]++;
+	}
+
+	Lengths.Sort();
+	MinPlies = Lengths[0];
+	MaxPlies = Lengths.Last();
+	MedianPlies = Lengths[NumGames / 2];
+	Percentile90Plies = Lengths[FMath::Min(NumGames * 9 / 10, NumGames - 1)];
+	MeanPlies = double(TotalPlies) / NumGames;
+}
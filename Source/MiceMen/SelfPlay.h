@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MatchState.h"
+
+// How one team picks its moves during self-play
+struct FSelfPlayPlayer
+{
+	// Zero plays a random legal move, otherwise the depth the computer opponent searches to
+	int32 SearchDepth = 0;
+
+	// Upper bound on the time spent on each searched move
+	float ThinkTime = 1.0f;
+};
+
+struct FSelfPlaySettings
+{
+	int32 NumGames = 1000;
+
+	// Game N generates its board and random moves from Seed and N only, so results don't depend on the thread count
+	int32 Seed = 0;
+
+	// Games still going after this many moves count as unfinished
+	int32 MaxPlies = 1000;
+
+	// Play boards FBoardGenerator accepted as fair, like an AGrid with bFairBoard set
+	bool bFairBoards = false;
+
+	FSelfPlayPlayer Blue;
+	FSelfPlayPlayer Red;
+
+	bool bSingleThreaded = false;
+};
+
+struct FSelfPlayGame
+{
+	// Seed of the board, an AGrid with this seed starts the same match
+	int32 Seed = 0;
+	EMatchResult Result = EMatchResult::Playing;
+	int32 Plies = 0;
+	int32 BlueScore = 0;
+	int32 RedScore = 0;
+};
+
+struct FSelfPlayStats
+{
+	// Width of the game length histogram buckets, in moves
+	static constexpr int32 HistogramBucketPlies = 25;
+
+	int32 NumGames = 0;
+	int32 BlueWins = 0;
+	int32 RedWins = 0;
+	int32 Draws = 0;
+	int32 Unfinished = 0;
+
+	int32 MinPlies = 0;
+	int32 MaxPlies = 0;
+	int32 MedianPlies = 0;
+	int32 Percentile90Plies = 0;
+	double MeanPlies = 0.0;
+
+	// Number of games whose length falls in each bucket
+	TArray<int32> PliesHistogram;
+
+	double Seconds = 0.0;
+	double GamesPerSecond = 0.0;
+
+	// Fill in the results and length statistics of a finished batch
+	void Accumulate(const TArray<FSelfPlayGame>& Games);
+};
+
+/**
+ * Plays complete matches without actors: board generation, moves, settling, scoring and
+ * the draw countdown all come from FBoardState and FMatchState. A game between random players
+ * takes microseconds, so rule variants and computer settings can be compared over many thousands.
+ */
+class MICEMEN_API FSelfPlay
+{
+public:
+	// Play game number GameIndex of a batch from start to end
+	static FSelfPlayGame PlayGame(const FSelfPlaySettings& Settings, int32 GameIndex);
+
+	// Play the whole batch spread over every worker thread, games are handed out in small blocks as threads free up
+	static FSelfPlayStats Run(const FSelfPlaySettings& Settings, TArray<FSelfPlayGame>* OutGames = nullptr);
+};
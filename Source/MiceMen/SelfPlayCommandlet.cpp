@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SelfPlayCommandlet.h"
+#include "MiceMen.h"
+#include "SelfPlay.h"
+#include "Misc/Parse.h"
+
+USelfPlayCommandlet::USelfPlayCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 USelfPlayCommandlet::Main(const FString& Params)
+{
+	FSelfPlaySettings Settings;
+	FParse::Value(*Params, TEXT("games="), Settings.NumGames);
+	FParse::Value(*Params, TEXT("seed="), Settings.Seed);
+	FParse::Value(*Params, TEXT("maxplies="), Settings.MaxPlies);
+	FParse::Value(*Params, TEXT("bluedepth="), Settings.Blue.SearchDepth);
+	FParse::Value(*Params, TEXT("reddepth="), Settings.Red.SearchDepth);
+	FParse::Value(*Params, TEXT("bluetime="), Settings.Blue.ThinkTime);
+	FParse::Value(*Params, TEXT("redtime="), Settings.Red.ThinkTime);
+	Settings.bSingleThreaded = FParse::Param(*Params, TEXT("singlethread"));
+	Settings.bFairBoards = FParse::Param(*Params, TEXT("fair"));
+
+	if (Settings.NumGames <= 0 || Settings.MaxPlies <= 0)
+	{
+		UE_LOG(LogMiceMen, Error, TEXT("SelfPlay: -games and -maxplies must be positive"));
+		return 1;
+	}
+
+	UE_LOG(LogMiceMen, Display, TEXT("SelfPlay: %d games, seed %d, blue depth %d, red depth %d%s"),
+		Settings.NumGames, Settings.Seed, Settings.Blue.SearchDepth, Settings.Red.SearchDepth, Settings.bFairBoards ? TEXT(", fair boards") : TEXT(""));
+
+	const FSelfPlayStats Stats = FSelfPlay::Run(Settings);
+
+	const double Percent = 100.0 / Stats.NumGames;
+	UE_LOG(LogMiceMen, Display, TEXT("Blue wins:  %d (%.1f%%)"), Stats.BlueWins, Stats.BlueWins * Percent);
+	UE_LOG(LogMiceMen, Display, TEXT("Red wins:   %d (%.1f%%)"), Stats.RedWins, Stats.RedWins * Percent);
+	UE_LOG(LogMiceMen, Display, TEXT("Draws:      %d (%.1f%%)"), Stats.Draws, Stats.Draws * Percent);
+	UE_LOG(LogMiceMen, Display, TEXT("Unfinished: %d (%.1f%%) after %d moves"), Stats.Unfinished, Stats.Unfinished * Percent, Settings.MaxPlies);
+	UE_LOG(LogMiceMen, Display, TEXT("Moves per game: min %d, median %d, mean %.1f, 90%% %d, max %d"),
+		Stats.MinPlies, Stats.MedianPlies, Stats.MeanPlies, Stats.Percentile90Plies, Stats.MaxPlies);
+
+	for (int32 Bucket = 0; Bucket < Stats.PliesHistogram.Num(); ++Bucket)
+	{
+		if (Stats.PliesHistogram[Bucket] > 0)
+		{
+			const int32 FirstPly = Bucket * FSelfPlayStats::HistogramBucketPlies;
+			UE_LOG(LogMiceMen, Display, TEXT("  %4d-%4d moves: %d"), FirstPly, FirstPly + FSelfPlayStats::HistogramBucketPlies - 1, Stats.PliesHistogram[Bucket]);
+		}
+	}
+
+	UE_LOG(LogMiceMen, Display, TEXT("%.2f seconds, %.1f games per second"), Stats.Seconds, Stats.GamesPerSecond);
+	return 0;
+}
@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SelfPlayCommandlet.generated.h"
+
+/**
+ * Plays a batch of headless games and logs the results. Run with
+ * UE4Editor-Cmd MiceMen.uproject -run=SelfPlay -games=10000 -seed=1 -bluedepth=3 -redtime=0.05
+ * Options: -games= -seed= -maxplies= -bluedepth= -reddepth= -bluetime= -redtime= -fair -singlethread
+ */
+UCLASS()
+class MICEMEN_API USelfPlayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USelfPlayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
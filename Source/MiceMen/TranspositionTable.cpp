@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TranspositionTable.h"
+
+constexpr int32 FTranspositionTable::BucketSize;
+
+// Layout of a slot's data: score in the low 32 bits, then depth, bound, move and the search generation
+static const int32 DepthShift = 32;
+static const int32 BoundShift = 40;
+static const int32 MoveShift = 48;
+static const int32 AgeShift = 56;
+
+static FORCEINLINE int32 UnpackDepth(uint64 Data) { return int32((Data >> DepthShift) & 0xFF); }
+static FORCEINLINE ETranspositionBound UnpackBound(uint64 Data) { return ETranspositionBound((Data >> BoundShift) & 0x3); }
+static FORCEINLINE uint8 UnpackAge(uint64 Data) { return uint8(Data >> AgeShift); }
+
+FTranspositionTable::FTranspositionTable(int32 SizeMB)
+	: NumBuckets(0)
+	, Generation(0)
+	, Probes(0)
+	, Hits(0)
+{
+	Resize(SizeMB);
+}
+
+void FTranspositionTable::Resize(int32 SizeMB)
+{
+	const uint64 BucketBytes = sizeof(FSlot) * BucketSize;
+	const uint64 Bytes = uint64(FMath::Max(SizeMB, 1)) * 1024 * 1024;
+
+	// A power of two lets the bucket be picked by masking the key
+	NumBuckets = int64(1) << FMath::FloorLog2_64(FMath::Max<uint64>(Bytes / BucketBytes, 1));
+	Slots = MakeUnique<FSlot[]>(NumBuckets * BucketSize);
+	Clear();
+}
+
+void FTranspositionTable::Clear()
+{
+	for (int64 i = 0; i < GetNumSlots(); ++i)
+	{
+		Slots[i].Check.Store(0, EMemoryOrder::Relaxed);
+		Slots[i].Data.Store(0, EMemoryOrder::Relaxed);
+	}
+	Generation.Store(0, EMemoryOrder::Relaxed);
+	Probes.Store(0, EMemoryOrder::Relaxed);
+	Hits.Store(0, EMemoryOrder::Relaxed);
+}
+
+void FTranspositionTable::NewSearch()
+{
+	++Generation;
+}
+
+bool FTranspositionTable::Probe(uint64 Key, FTranspositionEntry& OutEntry) const
+{
+	const FSlot* Bucket = &Slots[(Key & (NumBuckets - 1)) * BucketSize];
+	for (int32 i = 0; i < BucketSize; ++i)
+	{
+		const uint64 Data = Bucket[i].Data.Load(EMemoryOrder::Relaxed);
+		const uint64 Check = Bucket[i].Check.Load(EMemoryOrder::Relaxed);
+		if ((Check ^ Data) == Key && UnpackBound(Data) != ETranspositionBound::None)
+		{
+			const uint8 EncodedMove = uint8(Data >> MoveShift);
+			OutEntry.Score = int32(uint32(Data));
+			OutEntry.Depth = UnpackDepth(Data);
+			OutEntry.Bound = UnpackBound(Data);
+			OutEntry.Move = EncodedMove != 0 ? FBoardMove::Decode(EncodedMove - 1) : FBoardMove();
+			return true;
+		}
+	}
+	return false;
+}
+
+void FTranspositionTable::Store(uint64 Key, int32 Score, int32 Depth, ETranspositionBound Bound, FBoardMove Move)
+{
+	const uint8 CurrentGeneration = Generation.Load(EMemoryOrder::Relaxed);
+	FSlot* Bucket = &Slots[(Key & (NumBuckets - 1)) * BucketSize];
+	FSlot* Target = nullptr;
+	int32 TargetValue = TNumericLimits<int32>::Max();
+	for (int32 i = 0; i < BucketSize; ++i)
+	{
+		const uint64 Data = Bucket[i].Data.Load(EMemoryOrder::Relaxed);
+		const uint64 Check = Bucket[i].Check.Load(EMemoryOrder::Relaxed);
+		const ETranspositionBound SlotBound = UnpackBound(Data);
+		if ((Check ^ Data) == Key && SlotBound != ETranspositionBound::None)
+		{
+			// Keep a deeper result of this same search, unless the new one is exact
+			if (!bAlwaysReplace && UnpackAge(Data) == CurrentGeneration && Depth < UnpackDepth(Data) && Bound != ETranspositionBound::Exact)
+			{
+				return;
+			}
+			if (!Move.IsValid() && ((Data >> MoveShift) & 0xFF) != 0)
+			{
+				Move = FBoardMove::Decode(uint8(Data >> MoveShift) - 1);
+			}
+			Target = &Bucket[i];
+			break;
+		}
+
+		// Empty slots go first, then entries of older searches, then the shallowest ones
+		const int32 AgeDifference = uint8(CurrentGeneration - UnpackAge(Data));
+		int32 Value = SlotBound == ETranspositionBound::None ? TNumericLimits<int32>::Lowest() : -AgeDifference * 256;
+		if (!bAlwaysReplace && SlotBound != ETranspositionBound::None)
+		{
+			Value += UnpackDepth(Data);
+		}
+		if (Value < TargetValue)
+		{
+			Target = &Bucket[i];
+			TargetValue = Value;
+		}
+	}
+
+	const uint64 Data = Pack(Score, Depth, Bound, Move, CurrentGeneration);
+	Target->Check.Store(Key ^ Data, EMemoryOrder::Relaxed);
+	Target->Data.Store(Data, EMemoryOrder::Relaxed);
+}
+
+void FTranspositionTable::AddStats(int64 NewProbes, int64 NewHits)
+{
+	Probes += NewProbes;
+	Hits += NewHits;
+}
+
+double FTranspositionTable::GetHitRate() const
+{
+	const int64 NumProbes = GetProbes();
+	return NumProbes > 0 ? double(GetHits()) / double(NumProbes) : 0.0;
+}
+
+uint64 FTranspositionTable::Pack(int32 Score, int32 Depth, ETranspositionBound Bound, FBoardMove Move, uint8 Age)
+{
+	const uint64 EncodedMove = Move.IsValid() ? uint64(Move.Encode()) + 1 : 0;
+	return uint64(uint32(Score))
+		| uint64(FMath::Clamp(Depth, 0, 255)) << DepthShift
+		| uint64(Bound) << BoundShift
+		| EncodedMove << MoveShift
+		| uint64(Age) << AgeShift;
+}
@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Atomic.h"
+#include "MatchState.h"
+
+enum class ETranspositionBound : uint8
+{
+	None,
+	Exact,
+	// The real score is at least Score
+	Lower,
+	// The real score is at most Score
+	Upper
+};
+
+struct FTranspositionEntry
+{
+	int32 Score = 0;
+	int32 Depth = 0;
+	ETranspositionBound Bound = ETranspositionBound::None;
+	FBoardMove Move;
+};
+
+/**
+ * Fixed size hash table of searched positions, keyed by FMatchState::GetHash(). Several searches
+ * may probe and store at the same time without locks: every slot keeps its key XORed with its
+ * data, so a slot torn by two concurrent writes no longer matches any key and reads as a miss.
+ */
+class MICEMEN_API FTranspositionTable
+{
+public:
+	// Slots sharing one cache line, a store replaces the least valuable of them
+	static constexpr int32 BucketSize = 4;
+
+	explicit FTranspositionTable(int32 SizeMB = 16);
+
+	// Reallocate to the largest power of two number of buckets fitting in SizeMB, dropping every entry
+	void Resize(int32 SizeMB);
+	void Clear();
+
+	// Call before every search so entries of older searches get replaced first, searches on other threads may be running
+	void NewSearch();
+
+	bool Probe(uint64 Key, FTranspositionEntry& OutEntry) const;
+	void Store(uint64 Key, int32 Score, int32 Depth, ETranspositionBound Bound, FBoardMove Move);
+
+	// Searches count probes locally and add them here once they finish
+	void AddStats(int64 Probes, int64 Hits);
+	int64 GetProbes() const { return Probes.Load(EMemoryOrder::Relaxed); }
+	int64 GetHits() const { return Hits.Load(EMemoryOrder::Relaxed); }
+	double GetHitRate() const;
+
+	int64 GetNumSlots() const { return NumBuckets * BucketSize; }
+
+	// Overwrite the least valuable slot on every store instead of keeping deeper results
+	bool bAlwaysReplace = false;
+
+private:
+	struct FSlot
+	{
+		TAtomic<uint64> Check;
+		TAtomic<uint64> Data;
+	};
+
+	static uint64 Pack(int32 Score, int32 Depth, ETranspositionBound Bound, FBoardMove Move, uint8 Age);
+
+	TUniquePtr<FSlot[]> Slots;
+	int64 NumBuckets;
+	TAtomic<uint8> Generation;
+
+	TAtomic<int64> Probes;
+	TAtomic<int64> Hits;
+};
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Zobrist.h"
+
+FZobristKeys::FZobristKeys()
+{
+	uint64 State = 0x4D6963654D617463ull;
+	RedToMove = NextZobristKey(State);
+	for (int32 Team = 0; Team < 2; ++Team)
+	{
+		for (int32 Slot = 0; Slot < FMatchState::MoveHistoryLength; ++Slot)
+		{
+			for (int32 Column = 0; Column < FBoardState::Width; ++Column)
+			{
+				PreviousMoves[Team][Slot][Column] = NextZobristKey(State);
+			}
+		}
+	}
+	for (int32 Turns = 0; Turns <= FMatchState::DrawCountdownTurns; ++Turns)
+	{
+		TurnsBeforeDraw[Turns] = NextZobristKey(State);
+	}
+}
+
+const FZobristKeys& FZobristKeys::Get()
+{
+	static const FZobristKeys Keys;
+	return Keys;
+}
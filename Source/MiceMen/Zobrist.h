@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MatchState.h"
+
+// SplitMix64, good enough to spread a counter into independent looking keys
+FORCEINLINE uint64 NextZobristKey(uint64& State)
+{
+	uint64 Key = (State += 0x9E3779B97F4A7C15ull);
+	Key = (Key ^ (Key >> 30)) * 0xBF58476D1CE4E5B9ull;
+	Key = (Key ^ (Key >> 27)) * 0x94D049BB133111EBull;
+	return Key ^ (Key >> 31);
+}
+
+/**
+ * Random keys for Zobrist hashing of the pieces and scores of a board size. The keys are
+ * generated from a fixed seed, so hashes are the same in every process and on every machine.
+ */
+template<int32 InWidth, int32 InHeight, int32 InMicePerTeam>
+struct TBoardZobristKeys
+{
+	static constexpr int32 NumCells = InWidth * InHeight;
+
+	// Cheese, blue and red, indexed by X * Height + Y
+	uint64 Pieces[3][NumCells];
+	uint64 BlueScore[InMicePerTeam + 1];
+	uint64 RedScore[InMicePerTeam + 1];
+
+	static const TBoardZobristKeys& Get()
+	{
+		static const TBoardZobristKeys Keys;
+		return Keys;
+	}
+
+	FORCEINLINE uint64 Piece(EBoardCell Cell, int32 X, int32 Y) const
+	{
+		return Pieces[int32(Cell)][X * InHeight + Y];
+	}
+
+private:
+	TBoardZobristKeys()
+	{
+		uint64 State = 0x4D6963654D656E00ull;
+		for (int32 Type = 0; Type < 3; ++Type)
+		{
+			for (int32 Cell = 0; Cell < NumCells; ++Cell)
+			{
+				Pieces[Type][Cell] = NextZobristKey(State);
+			}
+		}
+		for (int32 Score = 0; Score <= InMicePerTeam; ++Score)
+		{
+			BlueScore[Score] = NextZobristKey(State);
+			RedScore[Score] = NextZobristKey(State);
+		}
+	}
+};
+
+/**
+ * Random keys for the parts of a match hash that aren't on the board: side to move,
+ * move history and draw countdown. Generated from their own fixed seed.
+ */
+struct MICEMEN_API FZobristKeys
+{
+	// Toggled when red is to move
+	uint64 RedToMove;
+
+	// Column moved by each team, per slot of the move history
+	uint64 PreviousMoves[2][FMatchState::MoveHistoryLength][FBoardState::Width];
+
+	// Only used once the draw countdown began
+	uint64 TurnsBeforeDraw[FMatchState::DrawCountdownTurns + 1];
+
+	static const FZobristKeys& Get();
+
+private:
+	FZobristKeys();
+};
@@ -0,0 +1,753 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MiceMenEnv.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const int32_t Width = MICEMENENV_WIDTH;
+	const int32_t Height = MICEMENENV_HEIGHT;
+	const int32_t MicePerTeam = MICEMENENV_MICE_PER_TEAM;
+	const int32_t MoveHistoryLength = 6;
+	const int32_t DrawCountdownTurns = 8;
+	const uint16_t ColumnMask = uint16_t((1u << Height) - 1);
+
+	// Boards settled together, each settle iteration takes one step on every board of the chunk
+	// until the slowest of them is settled
+	const int32_t ChunkSize = 64;
+
+	const uint8_t Blue = 1;
+	const uint8_t Red = 2;
+
+	// Same sequence as FRandomStream, so seeds give the boards of FMatchState::Generate
+	struct FEnvRandomStream
+	{
+		explicit FEnvRandomStream(int32_t InSeed) : Seed(uint32_t(InSeed)) {}
+
+		float GetFraction()
+		{
+			Seed = Seed * 196314165u + 907633515u;
+			const uint32_t Bits = 0x3F800000u | (Seed >> 9);
+			float Result;
+			std::memcpy(&Result, &Bits, sizeof(Result));
+			return Result - 1.0f;
+		}
+
+		int32_t RandRange(int32_t Min, int32_t Max)
+		{
+			const int32_t Range = Max - Min + 1;
+			return Min + (Range > 0 ? std::min(int32_t(GetFraction() * float(Range)), Range - 1) : 0);
+		}
+
+		uint32_t Seed;
+	};
+
+	int32_t CountBits(uint32_t Bits)
+	{
+		int32_t Count = 0;
+		for (; Bits != 0; Bits &= Bits - 1)
+		{
+			++Count;
+		}
+		return Count;
+	}
+
+	// Threads that live as long as the environment, so a step only wakes them instead of starting new ones
+	class FWorkerPool
+	{
+	public:
+		explicit FWorkerPool(int32_t NumWorkers)
+		{
+			// The calling thread does the first part itself
+			for (int32_t Worker = 1; Worker < NumWorkers; ++Worker)
+			{
+				Threads.emplace_back([this, Worker]() { WorkerLoop(Worker); });
+			}
+		}
+
+		~FWorkerPool()
+		{
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				bStop = true;
+			}
+			WorkReady.notify_all();
+			for (std::thread& Thread : Threads)
+			{
+				Thread.join();
+			}
+		}
+
+		int32_t GetNumWorkers() const { return int32_t(Threads.size()) + 1; }
+
+		// Call Task with every worker index once and return when all of them are done
+		void Run(const std::function<void(int32_t)>& InTask)
+		{
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				Task = &InTask;
+				Remaining = int32_t(Threads.size());
+				++Generation;
+			}
+			WorkReady.notify_all();
+			InTask(0);
+
+			std::unique_lock<std::mutex> Lock(Mutex);
+			WorkDone.wait(Lock, [this]() { return Remaining == 0; });
+			Task = nullptr;
+		}
+
+	private:
+		void WorkerLoop(int32_t Worker)
+		{
+			uint64_t SeenGeneration = 0;
+			for (;;)
+			{
+				const std::function<void(int32_t)>* WorkerTask;
+				{
+					std::unique_lock<std::mutex> Lock(Mutex);
+					WorkReady.wait(Lock, [this, SeenGeneration]() { return bStop || Generation != SeenGeneration; });
+					if (bStop)
+					{
+						return;
+					}
+					SeenGeneration = Generation;
+					WorkerTask = Task;
+				}
+				(*WorkerTask)(Worker);
+
+				std::lock_guard<std::mutex> Lock(Mutex);
+				if (--Remaining == 0)
+				{
+					WorkDone.notify_one();
+				}
+			}
+		}
+
+		std::vector<std::thread> Threads;
+		std::mutex Mutex;
+		std::condition_variable WorkReady;
+		std::condition_variable WorkDone;
+		const std::function<void(int32_t)>* Task = nullptr;
+		uint64_t Generation = 0;
+		int32_t Remaining = 0;
+		bool bStop = false;
+	};
+}
+
+struct MiceMenEnv
+{
+	int32_t NumBoards;
+	int32_t NumThreads;
+
+	// Boards rounded up to whole chunks, the extra boards stay empty and never move
+	int32_t Stride;
+
+	// Column X of board B is at X * Stride + B, one bit per row with bit 0 at the bottom like FBoardState
+	std::vector<uint16_t> Cheese;
+	std::vector<uint16_t> BlueMice;
+	std::vector<uint16_t> RedMice;
+
+	// Bit X is set if column X holds mice of the team, refreshed after every settle
+	std::vector<uint32_t> BlueColumns;
+	std::vector<uint32_t> RedColumns;
+
+	std::vector<uint8_t> SideToMove;
+	std::vector<uint8_t> BlueScore;
+	std::vector<uint8_t> RedScore;
+	std::vector<int8_t> TurnsBeforeDraw;
+	std::vector<uint8_t> bDrawCountdownBegan;
+
+	// Columns moved by each team, oldest first, MoveHistoryLength entries per team and board
+	std::vector<int8_t> PreviousMoves;
+	std::vector<uint8_t> NumPreviousMoves;
+
+	// Seed of the next match of each board, unsigned so long runs wrap around instead of overflowing
+	std::vector<uint32_t> NextSeed;
+
+	std::atomic<int64_t> SettleSteps;
+
+	// Null when every call runs on the calling thread alone
+	std::unique_ptr<FWorkerPool> Workers;
+};
+
+namespace
+{
+	int8_t* GetPreviousMoves(MiceMenEnv& Env, int32_t Board, int32_t Team)
+	{
+		return &Env.PreviousMoves[(Board * 2 + Team) * MoveHistoryLength];
+	}
+
+	const int8_t* GetPreviousMoves(const MiceMenEnv& Env, int32_t Board, int32_t Team)
+	{
+		return &Env.PreviousMoves[(Board * 2 + Team) * MoveHistoryLength];
+	}
+
+	void SetCell(MiceMenEnv& Env, int32_t Board, int32_t X, int32_t Y, uint8_t Cell)
+	{
+		const int32_t Index = X * Env.Stride + Board;
+		const uint16_t Bit = uint16_t(1u << Y);
+		(Cell == 0 ? Env.Cheese : Cell == Blue ? Env.BlueMice : Env.RedMice)[Index] |= Bit;
+	}
+
+	bool IsEmpty(const MiceMenEnv& Env, int32_t Board, int32_t X, int32_t Y)
+	{
+		const int32_t Index = X * Env.Stride + Board;
+		return ((Env.Cheese[Index] | Env.BlueMice[Index] | Env.RedMice[Index]) & (1u << Y)) == 0;
+	}
+
+	// Draw a new match the way FMatchState::Generate does, the board is left for the next settle
+	void GenerateBoard(MiceMenEnv& Env, int32_t Board)
+	{
+		for (int32_t x = 0; x < Width; ++x)
+		{
+			const int32_t Index = x * Env.Stride + Board;
+			Env.Cheese[Index] = 0;
+			Env.BlueMice[Index] = 0;
+			Env.RedMice[Index] = 0;
+		}
+		Env.BlueScore[Board] = 0;
+		Env.RedScore[Board] = 0;
+		Env.TurnsBeforeDraw[Board] = DrawCountdownTurns;
+		Env.bDrawCountdownBegan[Board] = 0;
+		Env.NumPreviousMoves[Board * 2] = 0;
+		Env.NumPreviousMoves[Board * 2 + 1] = 0;
+
+		FEnvRandomStream Random(int32_t(Env.NextSeed[Board]));
+		Env.NextSeed[Board] += uint32_t(Env.NumBoards);
+		Env.SideToMove[Board] = uint8_t(Random.RandRange(1, 2));
+
+		for (int32_t x = 0; x < Width; ++x)
+		{
+			for (int32_t y = 0; y < Height; ++y)
+			{
+				if (x == 0 || x == Width - 1)
+				{
+					if (y % 3 == 0)
+					{
+						SetCell(Env, Board, x, y, 0);
+					}
+				}
+				else if (Random.RandRange(0, 1) != 0)
+				{
+					SetCell(Env, Board, x, y, 0);
+				}
+			}
+		}
+
+		const uint8_t Teams[2] = { Red, Blue };
+		const int32_t FirstColumns[2] = { 0, Width / 2 + 1 };
+		for (int32_t Team = 0; Team < 2; ++Team)
+		{
+			int32_t NumberOfMice = MicePerTeam;
+			while (NumberOfMice > 0)
+			{
+				const int32_t x = Random.RandRange(FirstColumns[Team], FirstColumns[Team] + Width / 2 - 1);
+				const int32_t y = Random.RandRange(0, Height - 1);
+				if (IsEmpty(Env, Board, x, y))
+				{
+					SetCell(Env, Board, x, y, Teams[Team]);
+					--NumberOfMice;
+				}
+			}
+		}
+	}
+
+	/**
+	 * Settle every board of the chunk starting at First, taking the same steps in the same order as
+	 * FBoardState::Settle. Each iteration picks the lowest, leftmost movable mouse of every board and
+	 * moves it, the inner loops run across boards with no branches so the compiler turns them into SIMD.
+	 */
+	void SettleChunk(MiceMenEnv& Env, int32_t First)
+	{
+		const int32_t Stride = Env.Stride;
+		uint16_t* Cheese = &Env.Cheese[First];
+		uint16_t* BlueMice = &Env.BlueMice[First];
+		uint16_t* RedMice = &Env.RedMice[First];
+		int64_t Steps = 0;
+
+		// Occupied cells of every column with an empty column on each side for the goals
+		uint16_t Occupied[Width + 2][ChunkSize];
+		std::memset(Occupied[0], 0, sizeof(Occupied[0]));
+		std::memset(Occupied[Width + 1], 0, sizeof(Occupied[Width + 1]));
+
+		for (;;)
+		{
+			for (int32_t x = 0; x < Width; ++x)
+			{
+				const int32_t Column = x * Stride;
+				for (int32_t b = 0; b < ChunkSize; ++b)
+				{
+					Occupied[x + 1][b] = uint16_t(Cheese[Column + b] | BlueMice[Column + b] | RedMice[Column + b]);
+				}
+			}
+
+			// Lowest movable mouse as a single bit, its column, and whether it falls and is blue
+			uint16_t Best[ChunkSize];
+			int8_t BestX[ChunkSize];
+			uint8_t bFalls[ChunkSize];
+			uint8_t bBlue[ChunkSize];
+			std::memset(Best, 0, sizeof(Best));
+			std::memset(BestX, 0, sizeof(BestX));
+			std::memset(bFalls, 0, sizeof(bFalls));
+			std::memset(bBlue, 0, sizeof(bBlue));
+
+			for (int32_t x = 0; x < Width; ++x)
+			{
+				const int32_t Column = x * Stride;
+				for (int32_t b = 0; b < ChunkSize; ++b)
+				{
+					const uint16_t BlueColumn = BlueMice[Column + b];
+					const uint16_t RedColumn = RedMice[Column + b];
+					const uint16_t Falling = uint16_t((BlueColumn | RedColumn) & ~(Occupied[x + 1][b] << 1) & ~1u);
+					const uint16_t BlueWalking = uint16_t(BlueColumn & ~Occupied[x][b]);
+					const uint16_t RedWalking = uint16_t(RedColumn & ~Occupied[x + 2][b]);
+					const uint16_t Movable = uint16_t((Falling | BlueWalking | RedWalking) & ColumnMask);
+					const uint16_t Lowest = uint16_t(Movable & (0u - Movable));
+
+					// A lower row wins, on the same row the column found first stays
+					const bool bTake = Lowest != 0 && (Best[b] == 0 || Lowest < Best[b]);
+					Best[b] = bTake ? Lowest : Best[b];
+					BestX[b] = bTake ? int8_t(x) : BestX[b];
+					bFalls[b] = bTake ? uint8_t((Falling & Lowest) != 0) : bFalls[b];
+					bBlue[b] = bTake ? uint8_t((BlueColumn & Lowest) != 0) : bBlue[b];
+				}
+			}
+
+			uint16_t AnyMovable = 0;
+			for (int32_t b = 0; b < ChunkSize; ++b)
+			{
+				AnyMovable |= Best[b];
+			}
+			if (AnyMovable == 0)
+			{
+				break;
+			}
+
+			// Falling mice go one row down, walking ones one column ahead, possibly into a goal
+			int8_t ToX[ChunkSize];
+			uint16_t ToBit[ChunkSize];
+			for (int32_t b = 0; b < ChunkSize; ++b)
+			{
+				ToX[b] = bFalls[b] ? BestX[b] : int8_t(BestX[b] + (bBlue[b] ? -1 : 1));
+				ToBit[b] = bFalls[b] ? uint16_t(Best[b] >> 1) : Best[b];
+				Steps += Best[b] != 0;
+			}
+
+			for (int32_t x = 0; x < Width; ++x)
+			{
+				const int32_t Column = x * Stride;
+				for (int32_t b = 0; b < ChunkSize; ++b)
+				{
+					const uint16_t From = BestX[b] == x ? Best[b] : 0;
+					const uint16_t To = ToX[b] == x ? ToBit[b] : 0;
+					BlueMice[Column + b] = uint16_t((BlueMice[Column + b] & ~From) | (bBlue[b] ? To : 0));
+					RedMice[Column + b] = uint16_t((RedMice[Column + b] & ~From) | (bBlue[b] ? 0 : To));
+				}
+			}
+
+			for (int32_t b = 0; b < ChunkSize; ++b)
+			{
+				Env.BlueScore[First + b] += uint8_t(Best[b] != 0 && ToX[b] == -1);
+				Env.RedScore[First + b] += uint8_t(Best[b] != 0 && ToX[b] == Width);
+			}
+		}
+
+		Env.SettleSteps += Steps;
+	}
+
+	// Settle a single board, for new boards whose long initial cascade would hold up the rest of their chunk
+	void SettleBoard(MiceMenEnv& Env, int32_t Board)
+	{
+		uint16_t Cheese[Width];
+		uint16_t BlueMice[Width + 2] = {};
+		uint16_t RedMice[Width + 2] = {};
+		for (int32_t x = 0; x < Width; ++x)
+		{
+			Cheese[x] = Env.Cheese[x * Env.Stride + Board];
+			BlueMice[x + 1] = Env.BlueMice[x * Env.Stride + Board];
+			RedMice[x + 1] = Env.RedMice[x * Env.Stride + Board];
+		}
+
+		int64_t Steps = 0;
+		for (;;)
+		{
+			uint16_t Occupied[Width + 2] = {};
+			for (int32_t x = 0; x < Width; ++x)
+			{
+				Occupied[x + 1] = uint16_t(Cheese[x] | BlueMice[x + 1] | RedMice[x + 1]);
+			}
+
+			uint16_t Best = 0;
+			int32_t BestX = 0;
+			bool bFalls = false;
+			for (int32_t x = 1; x <= Width; ++x)
+			{
+				const uint16_t Falling = uint16_t((BlueMice[x] | RedMice[x]) & ~(Occupied[x] << 1) & ~1u);
+				const uint16_t Movable = uint16_t((Falling | (BlueMice[x] & ~Occupied[x - 1]) | (RedMice[x] & ~Occupied[x + 1])) & ColumnMask);
+				const uint16_t Lowest = uint16_t(Movable & (0u - Movable));
+				if (Lowest != 0 && (Best == 0 || Lowest < Best))
+				{
+					Best = Lowest;
+					BestX = x;
+					bFalls = (Falling & Lowest) != 0;
+				}
+			}
+			if (Best == 0)
+			{
+				break;
+			}
+
+			// Goals are the padding columns 0 and Width + 1, mice reaching them are scored and dropped
+			const bool bBlue = (BlueMice[BestX] & Best) != 0;
+			uint16_t* TeamMice = bBlue ? BlueMice : RedMice;
+			const int32_t ToX = bFalls ? BestX : BestX + (bBlue ? -1 : 1);
+			TeamMice[BestX] &= uint16_t(~Best);
+			TeamMice[ToX] |= bFalls ? uint16_t(Best >> 1) : Best;
+			Env.BlueScore[Board] += uint8_t(ToX == 0);
+			Env.RedScore[Board] += uint8_t(ToX == Width + 1);
+			BlueMice[0] = 0;
+			RedMice[Width + 1] = 0;
+			++Steps;
+		}
+
+		for (int32_t x = 0; x < Width; ++x)
+		{
+			Env.BlueMice[x * Env.Stride + Board] = BlueMice[x + 1];
+			Env.RedMice[x * Env.Stride + Board] = RedMice[x + 1];
+		}
+		Env.SettleSteps += Steps;
+	}
+
+	void UpdateTeamColumns(MiceMenEnv& Env, int32_t First)
+	{
+		uint32_t* BlueColumns = &Env.BlueColumns[First];
+		uint32_t* RedColumns = &Env.RedColumns[First];
+		std::memset(BlueColumns, 0, ChunkSize * sizeof(uint32_t));
+		std::memset(RedColumns, 0, ChunkSize * sizeof(uint32_t));
+		for (int32_t x = 0; x < Width; ++x)
+		{
+			const uint16_t* BlueMice = &Env.BlueMice[x * Env.Stride + First];
+			const uint16_t* RedMice = &Env.RedMice[x * Env.Stride + First];
+			for (int32_t b = 0; b < ChunkSize; ++b)
+			{
+				BlueColumns[b] |= uint32_t(BlueMice[b] != 0) << x;
+				RedColumns[b] |= uint32_t(RedMice[b] != 0) << x;
+			}
+		}
+	}
+
+	// FMatchState::GetLegalColumns for one board
+	uint32_t GetLegalColumns(const MiceMenEnv& Env, int32_t Board)
+	{
+		const uint8_t Side = Env.SideToMove[Board];
+		const int32_t Team = Side == Blue ? 0 : 1;
+		uint32_t Columns = Side == Blue ? Env.BlueColumns[Board] : Env.RedColumns[Board];
+
+		const int32_t NumOpponentMoves = Env.NumPreviousMoves[Board * 2 + 1 - Team];
+		if (NumOpponentMoves > 0 && CountBits(Columns) > 1)
+		{
+			// Not the other team's last column, nor a column moved on each of the team's last turns
+			uint32_t Filtered = Columns & ~(1u << GetPreviousMoves(Env, Board, 1 - Team)[NumOpponentMoves - 1]);
+			if (Env.NumPreviousMoves[Board * 2 + Team] == MoveHistoryLength)
+			{
+				const int8_t* Moves = GetPreviousMoves(Env, Board, Team);
+				bool bAllSame = true;
+				for (int32_t i = 1; i < MoveHistoryLength; ++i)
+				{
+					bAllSame = bAllSame && Moves[i] == Moves[0];
+				}
+				if (bAllSame)
+				{
+					Filtered &= ~(1u << Moves[0]);
+				}
+			}
+
+			// Never leave a team without any column to move
+			if (Filtered != 0)
+			{
+				Columns = Filtered;
+			}
+		}
+		return Columns;
+	}
+
+	void WriteObservation(const MiceMenEnv& Env, int32_t Board, uint8_t* Observation)
+	{
+		uint16_t Cheese[Width];
+		uint16_t BlueMice[Width];
+		uint16_t RedMice[Width];
+		for (int32_t x = 0; x < Width; ++x)
+		{
+			Cheese[x] = Env.Cheese[x * Env.Stride + Board];
+			BlueMice[x] = Env.BlueMice[x * Env.Stride + Board];
+			RedMice[x] = Env.RedMice[x * Env.Stride + Board];
+		}
+
+		// A cell holds at most one piece, so the cell value is 3 minus the value of whatever piece is there
+		for (int32_t y = 0; y < Height; ++y)
+		{
+			uint8_t* Row = Observation + y * Width;
+			for (int32_t x = 0; x < Width; ++x)
+			{
+				Row[x] = uint8_t(3 - 3 * ((Cheese[x] >> y) & 1) - 2 * ((BlueMice[x] >> y) & 1) - ((RedMice[x] >> y) & 1));
+			}
+		}
+
+		uint8_t* Extra = Observation + Width * Height;
+		const uint32_t LegalColumns = GetLegalColumns(Env, Board);
+		for (int32_t x = 0; x < Width; ++x)
+		{
+			Extra[x] = uint8_t((LegalColumns >> x) & 1);
+		}
+		Extra += Width;
+		Extra[0] = Env.SideToMove[Board];
+		Extra[1] = Env.BlueScore[Board];
+		Extra[2] = Env.RedScore[Board];
+		Extra[3] = Env.bDrawCountdownBegan[Board] ? uint8_t(std::max<int8_t>(Env.TurnsBeforeDraw[Board], 0)) : 0;
+	}
+
+	void ResetChunk(MiceMenEnv& Env, int32_t First, uint8_t* Observations)
+	{
+		const int32_t Last = std::min(First + ChunkSize, Env.NumBoards);
+		for (int32_t Board = First; Board < Last; ++Board)
+		{
+			GenerateBoard(Env, Board);
+			SettleBoard(Env, Board);
+		}
+		UpdateTeamColumns(Env, First);
+		if (Observations != nullptr)
+		{
+			for (int32_t Board = First; Board < Last; ++Board)
+			{
+				WriteObservation(Env, Board, Observations + int64_t(Board) * MICEMENENV_OBSERVATION_SIZE);
+			}
+		}
+	}
+
+	void StepChunk(MiceMenEnv& Env, int32_t First, const MiceMenAction* Actions, uint8_t* Observations, float* Rewards, uint8_t* Dones)
+	{
+		const int32_t Last = std::min(First + ChunkSize, Env.NumBoards);
+		int8_t MoveColumn[ChunkSize];
+		uint8_t bUpward[ChunkSize];
+		uint8_t bIllegal[ChunkSize];
+		uint8_t ScoresBefore[ChunkSize][2];
+		std::memset(MoveColumn, -1, sizeof(MoveColumn));
+		std::memset(bUpward, 0, sizeof(bUpward));
+		std::memset(bIllegal, 0, sizeof(bIllegal));
+
+		// Move history and draw countdown, as FMatchState::BeginMove
+		for (int32_t Board = First; Board < Last; ++Board)
+		{
+			const int32_t b = Board - First;
+			const MiceMenAction& Action = Actions[Board];
+			if (Action.Column < 0 || Action.Column >= Width || (GetLegalColumns(Env, Board) & (1u << Action.Column)) == 0)
+			{
+				bIllegal[b] = 1;
+				continue;
+			}
+			MoveColumn[b] = Action.Column;
+			bUpward[b] = Action.bUpward != 0;
+			ScoresBefore[b][0] = Env.BlueScore[Board];
+			ScoresBefore[b][1] = Env.RedScore[Board];
+
+			const int32_t Team = Env.SideToMove[Board] == Blue ? 0 : 1;
+			int8_t* Moves = GetPreviousMoves(Env, Board, Team);
+			uint8_t& NumMoves = Env.NumPreviousMoves[Board * 2 + Team];
+			if (NumMoves == MoveHistoryLength)
+			{
+				std::memmove(&Moves[0], &Moves[1], MoveHistoryLength - 1);
+				--NumMoves;
+			}
+			Moves[NumMoves++] = Action.Column;
+			if (Env.bDrawCountdownBegan[Board])
+			{
+				--Env.TurnsBeforeDraw[Board];
+			}
+		}
+
+		// Rotate the moved column of every board
+		for (int32_t x = 0; x < Width; ++x)
+		{
+			uint16_t* Pieces[3] = { &Env.Cheese[x * Env.Stride + First], &Env.BlueMice[x * Env.Stride + First], &Env.RedMice[x * Env.Stride + First] };
+			for (int32_t Type = 0; Type < 3; ++Type)
+			{
+				uint16_t* Column = Pieces[Type];
+				for (int32_t b = 0; b < ChunkSize; ++b)
+				{
+					const uint16_t Up = uint16_t(((Column[b] << 1) | (Column[b] >> (Height - 1))) & ColumnMask);
+					const uint16_t Down = uint16_t(((Column[b] >> 1) | (Column[b] << (Height - 1))) & ColumnMask);
+					Column[b] = MoveColumn[b] == x ? (bUpward[b] ? Up : Down) : Column[b];
+				}
+			}
+		}
+
+		SettleChunk(Env, First);
+		UpdateTeamColumns(Env, First);
+
+		// Draw countdown, turn change and match result, as FMatchState::EndMove and GetResult
+		bool bAnyDone = false;
+		for (int32_t Board = First; Board < Last; ++Board)
+		{
+			const int32_t b = Board - First;
+			float Reward = -float(MicePerTeam);
+			bool bDone = true;
+			if (!bIllegal[b])
+			{
+				const int32_t BlueGoals = Env.BlueScore[Board] - ScoresBefore[b][0];
+				const int32_t RedGoals = Env.RedScore[Board] - ScoresBefore[b][1];
+				Reward = float(Env.SideToMove[Board] == Blue ? BlueGoals - RedGoals : RedGoals - BlueGoals);
+
+				if (Env.BlueScore[Board] == MicePerTeam - 1 && Env.RedScore[Board] == MicePerTeam - 1)
+				{
+					Env.bDrawCountdownBegan[Board] = 1;
+				}
+				Env.SideToMove[Board] = Env.SideToMove[Board] == Blue ? Red : Blue;
+				bDone = Env.BlueScore[Board] >= MicePerTeam || Env.RedScore[Board] >= MicePerTeam
+					|| (Env.bDrawCountdownBegan[Board] && Env.TurnsBeforeDraw[Board] <= 0);
+			}
+
+			if (Rewards != nullptr)
+			{
+				Rewards[Board] = Reward;
+			}
+			if (Dones != nullptr)
+			{
+				Dones[Board] = uint8_t(bDone);
+			}
+			if (bDone)
+			{
+				GenerateBoard(Env, Board);
+				SettleBoard(Env, Board);
+				bAnyDone = true;
+			}
+		}
+
+		if (bAnyDone)
+		{
+			UpdateTeamColumns(Env, First);
+		}
+		if (Observations != nullptr)
+		{
+			for (int32_t Board = First; Board < Last; ++Board)
+			{
+				WriteObservation(Env, Board, Observations + int64_t(Board) * MICEMENENV_OBSERVATION_SIZE);
+			}
+		}
+	}
+
+	// Run Function on every chunk, split over the environment's threads
+	template<typename FunctionType>
+	void ForEachChunk(MiceMenEnv& Env, FunctionType Function)
+	{
+		const int32_t NumChunks = Env.Stride / ChunkSize;
+		if (!Env.Workers)
+		{
+			for (int32_t Chunk = 0; Chunk < NumChunks; ++Chunk)
+			{
+				Function(Chunk * ChunkSize);
+			}
+			return;
+		}
+
+		// Contiguous ranges of chunks so threads never share a cache line of board data
+		const int32_t NumWorkers = Env.Workers->GetNumWorkers();
+		Env.Workers->Run([&Function, NumChunks, NumWorkers](int32_t Worker)
+		{
+			const int32_t FirstChunk = NumChunks * Worker / NumWorkers;
+			const int32_t LastChunk = NumChunks * (Worker + 1) / NumWorkers;
+			for (int32_t Chunk = FirstChunk; Chunk < LastChunk; ++Chunk)
+			{
+				Function(Chunk * ChunkSize);
+			}
+		});
+	}
+}
+
+MiceMenEnv* MiceMenEnv_Create(int32_t NumBoards, int32_t Seed, int32_t NumThreads)
+{
+	if (NumBoards <= 0)
+	{
+		return nullptr;
+	}
+
+	MiceMenEnv* Env = new MiceMenEnv();
+	Env->NumBoards = NumBoards;
+	Env->NumThreads = std::max(NumThreads, 1);
+	Env->Stride = (NumBoards + ChunkSize - 1) / ChunkSize * ChunkSize;
+	Env->Cheese.assign(size_t(Env->Stride) * Width, 0);
+	Env->BlueMice.assign(size_t(Env->Stride) * Width, 0);
+	Env->RedMice.assign(size_t(Env->Stride) * Width, 0);
+	Env->BlueColumns.assign(Env->Stride, 0);
+	Env->RedColumns.assign(Env->Stride, 0);
+	Env->SideToMove.assign(Env->Stride, Blue);
+	Env->BlueScore.assign(Env->Stride, 0);
+	Env->RedScore.assign(Env->Stride, 0);
+	Env->TurnsBeforeDraw.assign(Env->Stride, DrawCountdownTurns);
+	Env->bDrawCountdownBegan.assign(Env->Stride, 0);
+	Env->PreviousMoves.assign(size_t(Env->Stride) * 2 * MoveHistoryLength, 0);
+	Env->NumPreviousMoves.assign(size_t(Env->Stride) * 2, 0);
+	Env->NextSeed.resize(Env->Stride);
+	for (int32_t Board = 0; Board < Env->Stride; ++Board)
+	{
+		Env->NextSeed[Board] = uint32_t(Seed) + uint32_t(Board);
+	}
+	Env->SettleSteps = 0;
+
+	const int32_t NumWorkers = std::min(Env->NumThreads, Env->Stride / ChunkSize);
+	if (NumWorkers > 1)
+	{
+		Env->Workers.reset(new FWorkerPool(NumWorkers));
+	}
+
+	MiceMenEnv_Reset(Env, nullptr);
+	return Env;
+}
+
+void MiceMenEnv_Destroy(MiceMenEnv* Env)
+{
+	delete Env;
+}
+
+int32_t MiceMenEnv_NumBoards(const MiceMenEnv* Env)
+{
+	return Env->NumBoards;
+}
+
+void MiceMenEnv_Reset(MiceMenEnv* Env, uint8_t* Observations)
+{
+	ForEachChunk(*Env, [Env, Observations](int32_t First)
+	{
+		ResetChunk(*Env, First, Observations);
+	});
+}
+
+void MiceMenEnv_Step(MiceMenEnv* Env, const MiceMenAction* Actions, uint8_t* Observations, float* Rewards, uint8_t* Dones)
+{
+	ForEachChunk(*Env, [Env, Actions, Observations, Rewards, Dones](int32_t First)
+	{
+		StepChunk(*Env, First, Actions, Observations, Rewards, Dones);
+	});
+}
+
+void MiceMenEnv_GetObservations(const MiceMenEnv* Env, uint8_t* Observations)
+{
+	for (int32_t Board = 0; Board < Env->NumBoards; ++Board)
+	{
+		WriteObservation(*Env, Board, Observations + int64_t(Board) * MICEMENENV_OBSERVATION_SIZE);
+	}
+}
+
+int64_t MiceMenEnv_GetSettleSteps(const MiceMenEnv* Env)
+{
+	return Env->SettleSteps.load();
+}
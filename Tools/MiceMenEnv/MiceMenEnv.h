@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/**
+ * Batched MiceMen environment for training move policies offline, without the engine. One call
+ * plays a move on every board of the batch following the rules of FMatchState: column rotation,
+ * settling in the same order, the move history and the draw countdown. Boards are stored as
+ * structure of arrays so each rule runs as one loop over many boards at a time.
+ *
+ * Seeds give the same boards as FMatchState::Generate with an FRandomStream of that seed.
+ */
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define MICEMENENV_API __declspec(dllexport)
+#else
+#define MICEMENENV_API __attribute__((visibility("default")))
+#endif
+
+#define MICEMENENV_WIDTH 19
+#define MICEMENENV_HEIGHT 13
+#define MICEMENENV_MICE_PER_TEAM 12
+
+/**
+ * Bytes of one board's observation:
+ * - WIDTH * HEIGHT cells, cell X, Y at Y * WIDTH + X with row 0 at the bottom: 0 cheese, 1 blue, 2 red, 3 empty
+ * - WIDTH legal column flags for the team to move, 1 if the column may be moved
+ * - Team to move (1 blue, 2 red), blue score, red score, and moves left before a draw (0 if the countdown has not begun)
+ */
+#define MICEMENENV_OBSERVATION_SIZE (MICEMENENV_WIDTH * MICEMENENV_HEIGHT + MICEMENENV_WIDTH + 4)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct MiceMenEnv MiceMenEnv;
+
+// A move of the team whose turn it is on one board
+typedef struct MiceMenAction
+{
+	int8_t Column;
+	uint8_t bUpward;
+} MiceMenAction;
+
+// Boards start their first match from seeds Seed, Seed + 1, ... and every new match on a board moves its
+// seed on by NumBoards. NumThreads above one splits every call over that many threads
+MICEMENENV_API MiceMenEnv* MiceMenEnv_Create(int32_t NumBoards, int32_t Seed, int32_t NumThreads);
+MICEMENENV_API void MiceMenEnv_Destroy(MiceMenEnv* Env);
+
+MICEMENENV_API int32_t MiceMenEnv_NumBoards(const MiceMenEnv* Env);
+
+// Start a new match on every board, Observations may be null
+MICEMENENV_API void MiceMenEnv_Reset(MiceMenEnv* Env, uint8_t* Observations);
+
+/**
+ * Play one action per board. Every output holds one entry per board and may be null.
+ * Rewards are the goals the moving team scored during the move minus the goals the other team scored,
+ * counted the way AGrid::AddToScore does. An illegal action loses the match and is rewarded -MICE_PER_TEAM.
+ * A board whose match ended is flagged in Dones and starts a new match right away, its observation shows the new match.
+ */
+MICEMENENV_API void MiceMenEnv_Step(MiceMenEnv* Env, const MiceMenAction* Actions, uint8_t* Observations, float* Rewards, uint8_t* Dones);
+
+MICEMENENV_API void MiceMenEnv_GetObservations(const MiceMenEnv* Env, uint8_t* Observations);
+
+// Settle steps taken by every board since the environment was created
+MICEMENENV_API int64_t MiceMenEnv_GetSettleSteps(const MiceMenEnv* Env);
+
+#ifdef __cplusplus
+}
+#endif